@@ -0,0 +1,213 @@
+/**
+ *	Contention benchmark: many threads adding into the same fixed-point
+ *	counter through a mutex, AtomicFixedPoint and ShardedAccumulator.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "fixedpoint_atomic.h"
+#include "bench.h"
+
+using namespace fastmath;
+
+
+/**
+ *	Minimal 64-bit raw variant, enough for AtomicFixedPoint.
+ */
+struct fixed64_t
+{
+	int64_t v;
+
+	static fixed64_t fromRaw( int64_t raw )		{ fixed64_t t; t.v = raw; return t; }
+	int64_t getRaw() const						{ return v; }
+};
+
+
+/**
+ *	Runs job( t ) on threads threads, t being the thread index.
+ */
+template<class Job>
+double runThreads( int32_t threads, Job job )
+{
+	std::vector<std::thread> pool;
+	double start = bench::nowMs();
+	for( int32_t t = 0; t < threads; ++t )
+	{
+		pool.push_back( std::thread( job, t ) );
+	}
+	for( size_t t = 0; t < pool.size(); ++t )
+	{
+		pool[ t ].join();
+	}
+	return bench::nowMs() - start;
+}
+
+
+/**
+ *	Every other operation under contention, against results that don't
+ *	depend on the interleaving.
+ */
+bool checkOperations( int32_t threads, int32_t ops )
+{
+	const fixed16_t one = fixed16_t::fromRaw( 1 );
+	const int32_t total = ops * threads;
+	bool ok = true;
+
+	// fetchSub back down to zero, ShardedAccumulator::sub along with add
+	{
+		AtomicFixedPoint<fixed16_t> atomic( fixed16_t::fromRaw( total ) );
+		ShardedAccumulator<fixed16_t> sharded;
+		runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				atomic.fetchSub( one );
+				sharded.add( fixed16_t::fromRaw( 3 ) );
+				sharded.sub( one );
+			}
+		} );
+		ok &= bench::check( atomic.load().getRaw() == 0, "fetchSub total" );
+		ok &= bench::check( sharded.sumRaw() == 2 * int64_t( total ), "ShardedAccumulator add / sub total" );
+	}
+
+	// increments through a compareExchange loop
+	{
+		AtomicFixedPoint<fixed16_t> atomic;
+		runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				fixed16_t expected = atomic.load();
+				while( !atomic.compareExchange( expected, expected + one ) ) {}
+			}
+		} );
+		ok &= bench::check( atomic.load().getRaw() == total, "compareExchange increments" );
+	}
+
+	// every thread offers its own share of 0 .. total - 1, as max and as min of the negated values;
+	// the value only moves one way, so the previous values seen by a thread must too
+	{
+		AtomicFixedPoint<fixed16_t> high( fixed16_t::fromRaw( -1 ) ), low( fixed16_t::fromRaw( 1 ) );
+		std::atomic<int32_t> monotonic( 1 );
+		runThreads( threads, [&]( int32_t t )
+		{
+			int32_t lastHigh = INT32_MIN, lastLow = INT32_MAX;
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				int32_t v = i * threads + t;
+				int32_t h = high.fetchMax( fixed16_t::fromRaw( v ) ).getRaw();
+				int32_t l = low.fetchMin( fixed16_t::fromRaw( -v ) ).getRaw();
+				if( h < lastHigh || l > lastLow ) monotonic = 0;
+				lastHigh = h;
+				lastLow = l;
+			}
+		} );
+		ok &= bench::check( high.load().getRaw() == total - 1, "fetchMax result" );
+		ok &= bench::check( low.load().getRaw() == -( total - 1 ), "fetchMin result" );
+		ok &= bench::check( monotonic != 0, "fetchMax / fetchMin previous values" );
+	}
+
+	// 14 exact doublings spread over the threads, a lost update would show
+	{
+		AtomicFixedPoint<fixed16_t> atomic( fixed16_t( 1 ) );
+		runThreads( threads, [&]( int32_t t )
+		{
+			for( int32_t i = t; i < 14; i += threads )
+			{
+				atomic.fetchMul( fixed16_t( 2 ) );
+			}
+		} );
+		ok &= bench::check( atomic.load().getRaw() == ( 16384 << 16 ), "fetchMul result" );
+	}
+
+	// and sign flips under full contention, an even number of them
+	{
+		AtomicFixedPoint<fixed16_t> atomic( fixed16_t( 1 ) );
+		runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ( ops & ~1 ); ++i )
+			{
+				atomic.fetchMul( fixed16_t( -1 ) );
+			}
+		} );
+		ok &= bench::check( atomic.load().getRaw() == ( 1 << 16 ), "fetchMul sign flips" );
+	}
+
+	return ok;
+}
+
+
+int main( int argc, char** argv )
+{
+	bench::Options opt( argc, argv );
+	const int32_t ops = opt.quick ? 20000 : 2000000;
+	const int32_t top = opt.quick && opt.maxThreads < 4 ? 4 : opt.maxThreads;
+	const fixed16_t one = fixed16_t::fromRaw( 1 );
+	bool ok = true;
+
+	// the 64-bit variant must keep every bit
+	{
+		AtomicFixedPoint<fixed64_t> wide;
+		int64_t step = int64_t( 1 ) << 40;
+		for( int32_t i = 0; i < 1000; ++i )
+		{
+			wide.fetchAdd( fixed64_t::fromRaw( step ) );
+		}
+		ok &= bench::check( wide.load().getRaw() == step * 1000, "64-bit AtomicFixedPoint" );
+	}
+
+	// 1, 2, 4, ... up to top
+	std::vector<int32_t> counts;
+	for( int32_t t = 1; t < top; t *= 2 ) counts.push_back( t );
+	counts.push_back( top );
+
+	printf( "threads\tmutex Mops/s\tatomic Mops/s\tsharded Mops/s\n" );
+
+	for( size_t c = 0; c < counts.size(); ++c )
+	{
+		int32_t threads = counts[ c ];
+		int64_t expected = int64_t( ops ) * threads;
+
+		std::mutex lock;
+		fixed16_t locked;
+		double tMutex = runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				std::lock_guard<std::mutex> guard( lock );
+				locked += one;
+			}
+		} );
+
+		AtomicFixedPoint<fixed16_t> atomic;
+		double tAtomic = runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				atomic.fetchAdd( one, std::memory_order_relaxed );
+			}
+		} );
+
+		ShardedAccumulator<fixed16_t> sharded;
+		double tSharded = runThreads( threads, [&]( int32_t )
+		{
+			for( int32_t i = 0; i < ops; ++i )
+			{
+				sharded.add( one );
+			}
+		} );
+
+		ok &= bench::check( locked.getRaw() == expected, "mutex total" );
+		ok &= bench::check( atomic.load().getRaw() == expected, "AtomicFixedPoint total" );
+		ok &= bench::check( sharded.sumRaw() == expected, "ShardedAccumulator total" );
+
+		printf( "%d\t%.1f\t\t%.1f\t\t%.1f\n", threads,
+				expected / ( tMutex * 1000.0 ), expected / ( tAtomic * 1000.0 ), expected / ( tSharded * 1000.0 ) );
+	}
+
+	ok &= checkOperations( top, opt.quick ? 20000 : 200000 );
+
+	return ok ? 0 : 1;
+}
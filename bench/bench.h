@@ -0,0 +1,60 @@
+/**
+ *	Shared helpers for the benchmarks.
+ */
+
+#ifndef FIXEDPOINT_BENCH_H
+#define FIXEDPOINT_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+
+
+namespace bench
+{
+
+	/**
+	 *	Command line: --quick shrinks the workload for ctest, --threads N
+	 *	sets the largest thread count to try.
+	 */
+	struct Options
+	{
+		bool		quick;
+		int32_t		maxThreads;
+
+		Options( int argc, char** argv ) : quick( false ), maxThreads( int32_t( std::thread::hardware_concurrency() ) )
+		{
+			for( int i = 1; i < argc; ++i )
+			{
+				if( !strcmp( argv[ i ], "--quick" ) ) quick = true;
+				else if( !strcmp( argv[ i ], "--threads" ) && i + 1 < argc ) maxThreads = atoi( argv[ ++i ] );
+			}
+
+			if( maxThreads < 1 ) maxThreads = 1;
+		}
+	};
+
+	inline double nowMs()
+	{
+		return std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
+
+	/**
+	 *	Fails the benchmark, a wrong result makes the timing meaningless.
+	 */
+	inline bool check( bool ok, const char* what )
+	{
+		if( !ok )
+		{
+			fprintf( stderr, "FAILED: %s\n", what );
+		}
+		return ok;
+	}
+
+}	// end of namespace bench
+
+
+#endif	// FIXEDPOINT_BENCH_H
@@ -0,0 +1,270 @@
+/**
+ *	Image kernels against a straightforward float implementation of the
+ *	same filters: bilinear and bicubic resampling, and alpha blending.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include "fixedpoint_image.h"
+#include "bench.h"
+
+using namespace fastmath;
+
+
+// float baseline
+
+template<int32_t taps>
+float tapWeight( float t, int32_t k )
+{
+	if( taps == 2 )
+	{
+		return k ? t : 1.0f - t;
+	}
+
+	float t2 = t * t, t3 = t2 * t;
+	switch( k )
+	{
+		case 0:		return 0.5f * ( -t3 + 2.0f * t2 - t );
+		case 1:		return 0.5f * ( 3.0f * t3 - 5.0f * t2 + 2.0f );
+		case 2:		return 0.5f * ( -3.0f * t3 + 4.0f * t2 + t );
+		default:	return 0.5f * ( t3 - t2 );
+	}
+}
+
+template<int32_t taps, typename pixel_t>
+void resampleFloat( const Image<pixel_t>& src, const Image<pixel_t>& dst )
+{
+	const int32_t ch = dst.channels;
+	const float maxValue = float( PixelInfo<pixel_t>::MAX );
+	std::vector<float> tmp( size_t( dst.height ) * src.width * ch );
+
+	// vertical
+	for( int32_t y = 0; y < dst.height; ++y )
+	{
+		double pos = ( y + 0.5 ) * src.height / dst.height - 0.5;
+		int32_t at = int32_t( floor( pos ) );
+		float t = float( pos - at );
+
+		for( int32_t i = 0; i < src.width * ch; ++i )
+		{
+			float acc = 0;
+			for( int32_t k = 0; k < taps; ++k )
+			{
+				acc += src.row( clampIndex( at + k - ( taps / 2 - 1 ), src.height ) )[ i ] * tapWeight<taps>( t, k );
+			}
+			tmp[ size_t( y ) * src.width * ch + i ] = acc;
+		}
+	}
+
+	// horizontal
+	for( int32_t x = 0; x < dst.width; ++x )
+	{
+		double pos = ( x + 0.5 ) * src.width / dst.width - 0.5;
+		int32_t at = int32_t( floor( pos ) );
+		float t = float( pos - at );
+
+		for( int32_t y = 0; y < dst.height; ++y )
+		{
+			const float* row = &tmp[ size_t( y ) * src.width * ch ];
+			for( int32_t c = 0; c < ch; ++c )
+			{
+				float acc = 0;
+				for( int32_t k = 0; k < taps; ++k )
+				{
+					acc += row[ clampIndex( at + k - ( taps / 2 - 1 ), src.width ) * ch + c ] * tapWeight<taps>( t, k );
+				}
+				acc = floorf( acc + 0.5f );
+				dst.row( y )[ x * ch + c ] = pixel_t( acc < 0 ? 0 : ( acc > maxValue ? maxValue : acc ) );
+			}
+		}
+	}
+}
+
+template<typename pixel_t>
+void alphaBlendFloat( const Image<pixel_t>& src, const Image<pixel_t>& alpha, const Image<pixel_t>& dst )
+{
+	const int32_t ch = dst.channels;
+	const float scale = 1.0f / PixelInfo<pixel_t>::MAX;
+
+	for( int32_t y = 0; y < dst.height; ++y )
+	{
+		for( int32_t x = 0; x < dst.width; ++x )
+		{
+			float a = alpha.row( y )[ x ] * scale;
+			for( int32_t c = 0; c < ch; ++c )
+			{
+				pixel_t* d = dst.row( y ) + x * ch + c;
+				*d = pixel_t( src.row( y )[ x * ch + c ] * a + *d * ( 1.0f - a ) + 0.5f );
+			}
+		}
+	}
+}
+
+
+// helpers
+
+template<typename pixel_t>
+struct Buffer
+{
+	std::vector<pixel_t> data;
+	Image<pixel_t> image;
+
+	Buffer( int32_t width, int32_t height, int32_t channels ) : data( size_t( width ) * height * channels + 1 )
+	{
+		Image<pixel_t> i = { &data[ 0 ], width, height, width * channels, channels };
+		image = i;
+	}
+};
+
+template<typename pixel_t>
+void fill( Buffer<pixel_t>& b, uint32_t seed )
+{
+	// smooth gradients with some noise, like a photo
+	const Image<pixel_t>& i = b.image;
+	for( int32_t y = 0; y < i.height; ++y )
+	{
+		for( int32_t x = 0; x < i.width * i.channels; ++x )
+		{
+			seed = seed * 1664525u + 1013904223u;
+			float v = 0.5f + 0.35f * sinf( x * 0.013f + y * 0.021f ) + ( int32_t( seed >> 24 ) - 128 ) / 2048.0f;
+			i.row( y )[ x ] = pixel_t( v * PixelInfo<pixel_t>::MAX );
+		}
+	}
+}
+
+template<typename pixel_t>
+int32_t maxDifference( const Image<pixel_t>& a, const Image<pixel_t>& b )
+{
+	int32_t worst = 0;
+	for( int32_t y = 0; y < a.height; ++y )
+	{
+		for( int32_t x = 0; x < a.width * a.channels; ++x )
+		{
+			int32_t d = abs( int32_t( a.row( y )[ x ] ) - int32_t( b.row( y )[ x ] ) );
+			worst = d > worst ? d : worst;
+		}
+	}
+	return worst;
+}
+
+/**
+ *	A hard vertical edge from black to white, the worst case for the
+ *	precision of the weights.
+ */
+template<typename pixel_t>
+void fillEdge( Buffer<pixel_t>& b, uint32_t )
+{
+	const Image<pixel_t>& i = b.image;
+	for( int32_t y = 0; y < i.height; ++y )
+	{
+		for( int32_t x = 0; x < i.width * i.channels; ++x )
+		{
+			i.row( y )[ x ] = pixel_t( x < i.width / 2 * i.channels ? 0 : PixelInfo<pixel_t>::MAX );
+		}
+	}
+}
+
+/**
+ *	scanlineStep against the loop it replaces.
+ */
+bool runScanline( float start, float step, int32_t count )
+{
+	std::vector<int32_t> integers( count );
+	std::vector<uint32_t> fractions( count );
+	scanlineStep( fixed16_t( start ), fixed16_t( step ), count, &integers[ 0 ], &fractions[ 0 ] );
+
+	bool same = true;
+	fixed16_t pos( start );
+	for( int32_t i = 0; i < count; ++i, pos += fixed16_t( step ) )
+	{
+		same &= integers[ i ] == pos.getInteger() && fractions[ i ] == pos.getFraction();
+	}
+	return bench::check( same, "scanlineStep" );
+}
+
+template<int32_t taps, typename pixel_t>
+bool runResample( const char* name, int32_t sw, int32_t sh, int32_t dw, int32_t dh, int32_t ch, int32_t threads, int32_t tolerance,
+				  void ( *source )( Buffer<pixel_t>&, uint32_t ) = fill<pixel_t> )
+{
+	Buffer<pixel_t> src( sw, sh, ch ), fixed( dw, dh, ch ), reference( dw, dh, ch );
+	source( src, 7 );
+
+	double t0 = bench::nowMs();
+	resampleFloat<taps>( src.image, reference.image );
+	double t1 = bench::nowMs();
+	resample<taps>( src.image, fixed.image, 1 );
+	double t2 = bench::nowMs();
+	resample<taps>( src.image, fixed.image, threads );
+	double t3 = bench::nowMs();
+
+	int32_t diff = maxDifference( fixed.image, reference.image );
+	printf( "%s\t%dx%d -> %dx%d x%d\t%.2f\t\t%.2f\t\t%.2f\t\t%d\n", name, sw, sh, dw, dh, ch, t1 - t0, t2 - t1, t3 - t2, diff );
+	return bench::check( diff <= tolerance, name );
+}
+
+template<typename pixel_t>
+bool runBlend( const char* name, int32_t w, int32_t h, int32_t ch, int32_t threads )
+{
+	Buffer<pixel_t> src( w, h, ch ), alpha( w, h, 1 ), fixed( w, h, ch ), reference( w, h, ch );
+	fill( src, 1 );
+	fill( alpha, 2 );
+	fill( fixed, 3 );
+	reference.data = fixed.data;
+
+	double t0 = bench::nowMs();
+	alphaBlendFloat( src.image, alpha.image, reference.image );
+	double t1 = bench::nowMs();
+	alphaBlend( src.image, alpha.image, fixed.image, threads );
+	double t2 = bench::nowMs();
+
+	int32_t diff = maxDifference( fixed.image, reference.image );
+	printf( "%s\t%dx%d x%d\t\t%.2f\t\t-\t\t%.2f\t\t%d\n", name, w, h, ch, t1 - t0, t2 - t1, diff );
+	return bench::check( diff <= 1, name );
+}
+
+
+int main( int argc, char** argv )
+{
+	bench::Options opt( argc, argv );
+	const int32_t w = opt.quick ? 301 : 3840;
+	const int32_t h = opt.quick ? 203 : 2160;
+	const int32_t threads = opt.maxThreads;
+	bool ok = true;
+
+	printf( "kernel\t\tsize\t\t\tfloat ms\tfixed ms\tfixed ms (%d threads)\tmax diff\n", threads );
+
+	for( int32_t ch = 1; ch <= 4; ++ch )
+	{
+		ok &= runResample<2, uint8_t>( "bilinear8", w, h, w / 2, h / 2, ch, threads, 2 );
+		ok &= runResample<2, uint8_t>( "bilinear8", w, h, w * 3 / 2, h * 3 / 2, ch, threads, 2 );
+		ok &= runResample<4, uint8_t>( "bicubic8", w, h, w / 2, h / 2, ch, threads, 3 );
+		ok &= runResample<4, uint8_t>( "bicubic8", w, h, w * 3 / 2, h * 3 / 2, ch, threads, 3 );
+		ok &= runBlend<uint8_t>( "blend8", w, h, ch, threads );
+	}
+
+	ok &= runResample<2, uint16_t>( "bilinear16", w, h, w / 3, h / 3, 4, threads, 2 );
+	ok &= runResample<2, uint16_t>( "bilinear16", w, h, w * 2, h * 2, 3, threads, 2 );
+	ok &= runResample<4, uint16_t>( "bicubic16", w, h, w / 3, h / 3, 4, threads, 2 );
+	ok &= runResample<4, uint16_t>( "bicubic16", w, h, w * 2, h * 2, 3, threads, 2 );
+	ok &= runResample<2, uint16_t>( "edge16", w, h, w * 2, h, 1, threads, 2, fillEdge<uint16_t> );
+	ok &= runResample<4, uint16_t>( "edge16", w, h, w * 3 / 2, h, 1, threads, 2, fillEdge<uint16_t> );
+	ok &= runResample<4, uint16_t>( "edge16", w, h, w / 3, h, 1, threads, 2, fillEdge<uint16_t> );
+	ok &= runBlend<uint16_t>( "blend16", w, h, 4, threads );
+
+	ok &= runScanline( -100.25f, 0.37f, 1000 );
+	ok &= runScanline( 30000.5f, -0.013f, 100000 );
+
+	// empty images write nothing and read nothing
+	{
+		Buffer<uint8_t> src( 0, 0, 4 ), dst( 8, 8, 4 );
+		src.image.pixels = 0;
+		for( size_t i = 0; i < dst.data.size(); ++i ) dst.data[ i ] = 42;
+		resampleBicubic( src.image, dst.image );
+		bool untouched = true;
+		for( size_t i = 0; i < dst.data.size(); ++i ) untouched &= dst.data[ i ] == 42;
+		ok &= bench::check( untouched, "empty source" );
+	}
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+/**
+ *	Lockstep simulation throughput, in entities per millisecond, for every
+ *	integrator and for the broadphase, over 1, 2, 4, ... threads.
+ */
+
+#include <vector>
+
+#include "fixedpoint_sim.h"
+#include "bench.h"
+
+using namespace fastmath;
+
+
+struct Spring
+{
+	inline void operator()( const fixed16_t& x, const fixed16_t& y, const fixed16_t& u, const fixed16_t& v, fixed16_t& ax, fixed16_t& ay ) const
+	{
+		ax = -x / 4 - u / 16;
+		ay = -y / 4 - v / 16 - fixed16_t( 1 );
+	}
+};
+
+static BodySet<fixed16_t> makeScene( int32_t count, int32_t side )
+{
+	BodySet<fixed16_t> b;
+	uint32_t seed = 1;
+	for( int32_t i = 0; i < count; ++i )
+	{
+		int32_t v[ 4 ];
+		for( int32_t k = 0; k < 4; ++k )
+		{
+			seed = seed * 1664525u + 1013904223u;
+			v[ k ] = int32_t( seed >> 8 );
+		}
+
+		b.add( fixed16_t::fromRaw( v[ 0 ] % ( side << 16 ) ), fixed16_t::fromRaw( v[ 1 ] % ( side << 16 ) ),
+			   fixed16_t::fromRaw( ( v[ 2 ] & 0xfffff ) - 0x80000 ), fixed16_t::fromRaw( ( v[ 3 ] & 0xfffff ) - 0x80000 ),
+			   fixed16_t( 0.4f ) );
+	}
+	return b;
+}
+
+
+int main( int argc, char** argv )
+{
+	bench::Options opt( argc, argv );
+	const int32_t bodies = opt.quick ? 20000 : 1000000;
+	const int32_t side = opt.quick ? 200 : 1000;		// about one body every two cells
+	const int32_t steps = opt.quick ? 4 : 20;
+	const int32_t top = opt.quick && opt.maxThreads < 4 ? 4 : opt.maxThreads;
+	const fixed16_t dt = fixed16_t( 1.0f / 60 );
+	Spring spring;
+	bool ok = true;
+
+	std::vector<int32_t> counts;
+	for( int32_t t = 1; t < top; t *= 2 ) counts.push_back( t );
+	counts.push_back( top );
+
+	printf( "threads\tEuler\t\tVerlet\t\tRK4\t\tbroadphase\t(entities/ms)\n" );
+
+	uint64_t reference[ 3 ] = {};
+	size_t referencePairs = 0;
+
+	for( size_t c = 0; c < counts.size(); ++c )
+	{
+		int32_t threads = counts[ c ];
+		double rate[ 4 ];
+
+		for( int32_t g = 0; g < 3; ++g )
+		{
+			BodySet<fixed16_t> b = makeScene( bodies, side );
+			double start = bench::nowMs();
+			for( int32_t s = 0; s < steps; ++s )
+			{
+				switch( g )
+				{
+					case 0:		integrateEuler( b, spring, dt, threads ); break;
+					case 1:		integrateVerlet( b, spring, dt, threads ); break;
+					default:	integrateRK4( b, spring, dt, threads ); break;
+				}
+			}
+			rate[ g ] = double( bodies ) * steps / ( bench::nowMs() - start );
+
+			uint64_t h = stateHash( b );
+			if( !c ) reference[ g ] = h;
+			ok &= bench::check( h == reference[ g ], "state hash across thread counts" );
+		}
+
+		BodySet<fixed16_t> b = makeScene( bodies, side );
+		UniformGrid<fixed16_t> grid( fixed16_t( 1 ) );
+		std::vector<BodyPair> pairs;
+		double start = bench::nowMs();
+		for( int32_t s = 0; s < steps; ++s )
+		{
+			grid.build( b, threads );
+			grid.findPairs( b, pairs, threads );
+		}
+		rate[ 3 ] = double( bodies ) * steps / ( bench::nowMs() - start );
+
+		if( !c ) referencePairs = pairs.size();
+		ok &= bench::check( pairs.size() == referencePairs, "pair count across thread counts" );
+
+		printf( "%d\t%.0f\t\t%.0f\t\t%.0f\t\t%.0f\n", threads, rate[ 0 ], rate[ 1 ], rate[ 2 ], rate[ 3 ] );
+	}
+
+	return ok ? 0 : 1;
+}
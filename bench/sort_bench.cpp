@@ -0,0 +1,112 @@
+/**
+ *	radixSort against std::sort, FixedPointIndex against std::lower_bound.
+ */
+
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+#include "fixedpoint_sort.h"
+#include "bench.h"
+
+using namespace fastmath;
+
+
+static bool byRaw( const fixed16_t& a, const fixed16_t& b )		{ return a.getRaw() < b.getRaw(); }
+
+static bool byKey( const std::pair<fixed16_t, uint32_t>& a, const std::pair<fixed16_t, uint32_t>& b )
+{
+	return a.first.getRaw() < b.first.getRaw();
+}
+
+
+int main( int argc, char** argv )
+{
+	bench::Options opt( argc, argv );
+	const size_t sizes[] = { 1000, 100000, 4000000 };
+	const size_t runs = opt.quick ? 2 : 3;
+	bool ok = true;
+
+	srand( 1 );
+	printf( "n\tstd::sort ms\tradixSort ms\tkv std::stable_sort ms\tkv radixSort ms\tstd::lower_bound Mq/s\tFixedPointIndex Mq/s\n" );
+
+	for( size_t s = 0; s < runs; ++s )
+	{
+		const size_t n = sizes[ s ];
+		const size_t queries = opt.quick ? 10000 : 2000000;
+
+		std::vector<fixed16_t> data( n );
+		for( size_t i = 0; i < n; ++i )
+		{
+			// signed, with plenty of duplicates in the narrow half
+			int32_t r = int32_t( ( uint32_t( rand() ) << 16 ) ^ uint32_t( rand() ) );
+			data[ i ] = fixed16_t::fromRaw( i & 1 ? r : r % 1000 );
+		}
+
+		// plain sort
+		std::vector<fixed16_t> a( data ), b( data );
+		double t0 = bench::nowMs();
+		std::sort( a.begin(), a.end(), byRaw );
+		double t1 = bench::nowMs();
+		radixSort( &b[ 0 ], n );
+		double t2 = bench::nowMs();
+
+		bool same = true;
+		for( size_t i = 0; i < n; ++i )
+		{
+			same &= a[ i ].getRaw() == b[ i ].getRaw();
+		}
+		ok &= bench::check( same, "radixSort order" );
+
+		// key-value, radixSort is stable so compare against stable_sort
+		std::vector< std::pair<fixed16_t, uint32_t> > pairs( n );
+		std::vector<fixed16_t> keys( data );
+		std::vector<uint32_t> values( n );
+		for( size_t i = 0; i < n; ++i )
+		{
+			pairs[ i ] = std::make_pair( data[ i ], uint32_t( i ) );
+			values[ i ] = uint32_t( i );
+		}
+
+		double t3 = bench::nowMs();
+		std::stable_sort( pairs.begin(), pairs.end(), byKey );
+		double t4 = bench::nowMs();
+		radixSort( &keys[ 0 ], &values[ 0 ], n );
+		double t5 = bench::nowMs();
+
+		for( size_t i = 0; i < n; ++i )
+		{
+			same &= pairs[ i ].second == values[ i ] && pairs[ i ].first.getRaw() == keys[ i ].getRaw();
+		}
+		ok &= bench::check( same, "key-value radixSort" );
+
+		// lookups, half of them hitting existing keys
+		std::vector<fixed16_t> probe( queries );
+		for( size_t q = 0; q < queries; ++q )
+		{
+			probe[ q ] = q & 1 ? b[ size_t( rand() ) % n ] : fixed16_t::fromRaw( int32_t( ( uint32_t( rand() ) << 16 ) ^ uint32_t( rand() ) ) );
+		}
+
+		FixedPointIndex<fixed16_t> index( &b[ 0 ], n );
+		std::vector<size_t> expected( queries ), found( queries );
+
+		double t6 = bench::nowMs();
+		for( size_t q = 0; q < queries; ++q )
+		{
+			expected[ q ] = std::lower_bound( b.begin(), b.end(), probe[ q ], byRaw ) - b.begin();
+		}
+		double t7 = bench::nowMs();
+		for( size_t q = 0; q < queries; ++q )
+		{
+			found[ q ] = index.lowerBound( probe[ q ] );
+		}
+		double t8 = bench::nowMs();
+
+		ok &= bench::check( found == expected, "FixedPointIndex::lowerBound" );
+
+		printf( "%zu\t%.2f\t\t%.2f\t\t%.2f\t\t\t%.2f\t\t%.1f\t\t\t%.1f\n", n, t1 - t0, t2 - t1, t4 - t3, t5 - t4,
+				queries / ( ( t7 - t6 ) * 1000.0 ), queries / ( ( t8 - t7 ) * 1000.0 ) );
+	}
+
+	return ok ? 0 : 1;
+}
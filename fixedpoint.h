@@ -26,11 +26,18 @@
 #define FIXEDPOINT_H
 
 #include <stdint.h>
+#include <math.h>
+
+#if __cplusplus >= 201103L
+#include <type_traits>
+#endif
 
 
 namespace fastmath
 {
 
+	typedef bool bool_t;
+
 	/**
 	 *	Mantains precalculated basic information such
 	 *	as bit-masks and other constants.
@@ -55,6 +62,12 @@ namespace fastmath
 			 template <int32_t> class DivPrecisionPolicy>
 	class FixedPoint : public FixedPointInfo<precision_bits>
 	{
+		protected:
+
+			using FixedPointInfo<precision_bits>::FRACTION_MASK;
+			using FixedPointInfo<precision_bits>::ONE;
+			using FixedPointInfo<precision_bits>::ROUND;
+
 		public:
 
 
@@ -64,7 +77,7 @@ namespace fastmath
 			template<int32_t bits, template <int32_t> class mulP, template <int32_t> class divP>
 			explicit FixedPoint( const FixedPoint<bits, mulP, divP>& rhs )
 			{
-				v = translate( rhs.v, bits );
+				v = translate( rhs.getRaw(), bits );
 			}
 
 
@@ -77,7 +90,7 @@ namespace fastmath
 			template<int32_t bits, template <int32_t> class mulP, template <int32_t> class divP>
 			inline FixedPoint& operator=( const FixedPoint<bits, mulP, divP>& rhs )
 			{
-				v = translate( rhs.v, bits );
+				v = translate( rhs.getRaw(), bits );
 				return *this;
 			}
 
@@ -85,13 +98,11 @@ namespace fastmath
 			/** Construction */
 			inline static FixedPoint fromRaw( int32_t raw )	{ FixedPoint tmp; tmp.v = raw; return tmp; }
 			FixedPoint() : v( 0 ) {}
-			FixedPoint( const FixedPoint& rhs )	: v( rhs.v ) {}
 			explicit FixedPoint( float_t rhs )			: v( (int32_t)( rhs *  (float_t)ONE + ( rhs < 0 ? -0.5f : 0.5f ) ) ) {}
 			explicit FixedPoint( double_t rhs )			: v( (int32_t)( rhs * (double_t)ONE + ( rhs < 0 ? -0.5f : 0.5f ) ) ) {}
-			explicit FixedPoint( int32_t rhs )			: v( rhs << precision_bits ) {}
+			explicit FixedPoint( int32_t rhs )			: v( int32_t( uint32_t( rhs ) << precision_bits ) ) {}
 
 			/** FixedPoint assignment */
-			inline FixedPoint& operator=( const FixedPoint& rhs )		{ v = rhs.v; return *this; }
 			inline FixedPoint& operator+=( const FixedPoint& rhs )	{ v += rhs.v; return *this; }
 			inline FixedPoint& operator-=( const FixedPoint& rhs )	{ v -= rhs.v; return *this; }
 			//inline FixedPoint& operator*=( const FixedPoint& rhs )	{ v = mul_t::mul( v, rhs.v ); return *this; }
@@ -676,6 +687,10 @@ namespace fastmath
 	template<int32_t bits>
 	class HighPrecision : public FixedPointInfo<bits>
 	{
+		protected:
+
+			using FixedPointInfo<bits>::ROUND;
+
 		public:
 
 			inline static int32_t mul( int32_t l, int32_t r )
@@ -735,12 +750,16 @@ namespace fastmath
 	template<int32_t bits>
 	class MidPrecision : public FixedPointInfo<bits>
 	{
+		protected:
+
+			using FixedPointInfo<bits>::SIGN_BIT;
+
 		public:
 
 			inline static int32_t mul( int32_t l, int32_t r )
 			{
-				register unsigned int a,b;
-				register bool sign;
+				unsigned int a,b;
+				bool sign;
 
 				int32_t a1 = l, b1 = r;
 
@@ -752,7 +771,7 @@ namespace fastmath
 				a = (((unsigned int)a1) >> bits); a1 &= ~(a << bits);
 				b = (((unsigned int)b1) >> bits); b1 &= ~(b << bits);
 				a1 = ((a*b) << bits) + (a*b1 + b*a1) +
-					((unsigned int)((a1*b1) + (1 << (bits-1))) >> bits);
+					(((unsigned int)a1*(unsigned int)b1 + (1u << (bits-1))) >> bits);
 
 				if (a1 < 0) {a1 ^= static_cast<int32_t>( SIGN_BIT );}
 				if (sign) {a1 = -a1;}
@@ -761,8 +780,8 @@ namespace fastmath
 
 			inline static int32_t div( int32_t l, int32_t r )
 			{
-				register int res, mask;
-				register bool sign;
+				int res, mask;
+				bool sign;
 
 				int32_t a = l, b = r;
 
@@ -795,9 +814,10 @@ namespace fastmath
 	{
 		public:
 
+			// the product wraps past the int32_t range, that's the precision given up
 			inline static int32_t mul( int32_t l, int32_t r )
 			{
-				return ( ( l * r ) >> bits );
+				return ( int32_t( uint32_t( l ) * uint32_t( r ) ) >> bits );
 			}
 
 			inline static int32_t div( int32_t l, int32_t r )
@@ -813,6 +833,17 @@ namespace fastmath
 	typedef FixedPoint< 16, HighPrecision, HighPrecision > fixed16_t;
 	typedef fixed16_t fixed_t;
 
+
+#if __cplusplus >= 201103L
+	// The wrapper must stay as cheap to pass around as the raw int32_t
+	static_assert( std::is_trivially_copyable<fixed8_t>::value, "fixed8_t must be trivially copyable" );
+	static_assert( std::is_trivially_copyable<fixed16_t>::value, "fixed16_t must be trivially copyable" );
+	static_assert( std::is_standard_layout<fixed8_t>::value, "fixed8_t must be standard-layout" );
+	static_assert( std::is_standard_layout<fixed16_t>::value, "fixed16_t must be standard-layout" );
+	static_assert( sizeof( fixed8_t ) == sizeof( int32_t ), "fixed8_t must be the size of its raw value" );
+	static_assert( sizeof( fixed16_t ) == sizeof( int32_t ), "fixed16_t must be the size of its raw value" );
+#endif
+
 }	// end of namespace fastmath
 
 
@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_ATOMIC_H
+#define FIXEDPOINT_ATOMIC_H
+
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include "fixedpoint.h"
+
+
+namespace fastmath
+{
+
+	enum { CACHE_LINE_SIZE = 64 };
+
+
+	/**
+	 *	Lock-free atomic wrapper around a FixedPoint quantity.
+	 *
+	 *	All the operations work directly on the raw integer, add and subtract
+	 *	map onto the hardware fetch-and-add while multiply, min and max are
+	 *	performed through a compare-and-swap loop, using the precision policy
+	 *	of the wrapped type for the multiplication.
+	 *
+	 *	The storage follows the raw type of the wrapped class, so that a
+	 *	64-bit variant only needs to provide the same fromRaw() / getRaw()
+	 *	pair, taking and returning int64_t.
+	 */
+	template<class Fixed, typename raw_t = decltype( std::declval<const Fixed&>().getRaw() )>
+	class AtomicFixedPoint
+	{
+		static_assert( std::is_same<raw_t, decltype( std::declval<const Fixed&>().getRaw() )>::value,
+					   "raw_t must match the raw type of Fixed, or values would be truncated" );
+
+		public:
+
+			/** Construction */
+			AtomicFixedPoint() : v( 0 ) {}
+			explicit AtomicFixedPoint( const Fixed& rhs ) : v( rhs.getRaw() ) {}
+
+			inline bool_t isLockFree() const	{ return v.is_lock_free(); }
+
+			/** Plain access */
+			inline Fixed load( std::memory_order order = std::memory_order_seq_cst ) const
+			{
+				return Fixed::fromRaw( v.load( order ) );
+			}
+
+			inline void store( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				v.store( rhs.getRaw(), order );
+			}
+
+			inline Fixed exchange( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				return Fixed::fromRaw( v.exchange( rhs.getRaw(), order ) );
+			}
+
+			/**
+			 *	On failure, expected is updated with the current value.
+			 */
+			inline bool_t compareExchange( Fixed& expected, const Fixed& desired, std::memory_order order = std::memory_order_seq_cst )
+			{
+				raw_t cur = expected.getRaw();
+				bool_t done = v.compare_exchange_strong( cur, desired.getRaw(), order );
+				expected = Fixed::fromRaw( cur );
+				return done;
+			}
+
+			/** Read-modify-write, all of them return the previous value */
+			inline Fixed fetchAdd( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				return Fixed::fromRaw( v.fetch_add( rhs.getRaw(), order ) );
+			}
+
+			inline Fixed fetchSub( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				return Fixed::fromRaw( v.fetch_sub( rhs.getRaw(), order ) );
+			}
+
+			inline Fixed fetchMul( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				raw_t cur = v.load( std::memory_order_relaxed );
+				while( !v.compare_exchange_weak( cur, ( Fixed::fromRaw( cur ) * rhs ).getRaw(), order, std::memory_order_relaxed ) ) {}
+				return Fixed::fromRaw( cur );
+			}
+
+			inline Fixed fetchMin( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				raw_t r = rhs.getRaw();
+				raw_t cur = v.load( std::memory_order_relaxed );
+				while( r < cur && !v.compare_exchange_weak( cur, r, order, std::memory_order_relaxed ) ) {}
+				return Fixed::fromRaw( cur );
+			}
+
+			inline Fixed fetchMax( const Fixed& rhs, std::memory_order order = std::memory_order_seq_cst )
+			{
+				raw_t r = rhs.getRaw();
+				raw_t cur = v.load( std::memory_order_relaxed );
+				while( r > cur && !v.compare_exchange_weak( cur, r, order, std::memory_order_relaxed ) ) {}
+				return Fixed::fromRaw( cur );
+			}
+
+			/** Assignment */
+			inline AtomicFixedPoint& operator=( const Fixed& rhs )		{ store( rhs ); return *this; }
+			inline AtomicFixedPoint& operator+=( const Fixed& rhs )		{ fetchAdd( rhs ); return *this; }
+			inline AtomicFixedPoint& operator-=( const Fixed& rhs )		{ fetchSub( rhs ); return *this; }
+			inline AtomicFixedPoint& operator*=( const Fixed& rhs )		{ fetchMul( rhs ); return *this; }
+
+			/** converters */
+			inline operator Fixed() const								{ return load(); }
+
+
+		private:
+
+			std::atomic<raw_t> v;
+
+			AtomicFixedPoint( const AtomicFixedPoint& );
+			AtomicFixedPoint& operator=( const AtomicFixedPoint& );
+	};
+
+
+	// local helpers
+
+	/**
+	 *	Hands out a small, per-thread index in a round-robin fashion, the
+	 *	first time a thread asks for it.
+	 */
+	inline uint32_t threadSlot()
+	{
+		static std::atomic<uint32_t> next( 0 );
+		static thread_local uint32_t slot = next.fetch_add( 1, std::memory_order_relaxed );
+		return slot;
+	}
+
+
+	/**
+	 *	Contention-free accumulator for FixedPoint quantities.
+	 *
+	 *	Every thread adds into its own cache-line sized shard, so that
+	 *	concurrent updates never bounce the same line between cores; reading
+	 *	sums all the shards.
+	 *
+	 *	Shards are kept as int64_t, so the sum is exact as long as the total
+	 *	fits 64 bits, even when the single shards exceed the range of the
+	 *	wrapped type. Reads running concurrently with writers see each shard
+	 *	atomically, but not a single snapshot of all of them.
+	 */
+	template<class Fixed, int32_t shards = 16>
+	class ShardedAccumulator
+	{
+		public:
+
+			ShardedAccumulator()									{ reset(); }
+
+			inline void add( const Fixed& rhs )						{ slot().fetch_add( rhs.getRaw(), std::memory_order_relaxed ); }
+			inline void sub( const Fixed& rhs )						{ slot().fetch_sub( rhs.getRaw(), std::memory_order_relaxed ); }
+
+			inline ShardedAccumulator& operator+=( const Fixed& rhs )	{ add( rhs ); return *this; }
+			inline ShardedAccumulator& operator-=( const Fixed& rhs )	{ sub( rhs ); return *this; }
+
+			/**
+			 *	Gives access to the exact sum, as a raw value.
+			 */
+			inline int64_t sumRaw() const
+			{
+				int64_t t = 0;
+				for( int32_t i = 0; i < shards; ++i )
+				{
+					t += s[ i ].v.load( std::memory_order_relaxed );
+				}
+				return t;
+			}
+
+			/**
+			 *	Sum narrowed down to the wrapped type, wraps on overflow.
+			 */
+			inline Fixed sum() const								{ return Fixed::fromRaw( sumRaw() ); }
+
+			inline void reset()
+			{
+				for( int32_t i = 0; i < shards; ++i )
+				{
+					s[ i ].v.store( 0, std::memory_order_relaxed );
+				}
+			}
+
+
+		private:
+
+			struct alignas( CACHE_LINE_SIZE ) Shard
+			{
+				std::atomic<int64_t> v;
+			};
+
+			Shard s[ shards ];
+
+			inline std::atomic<int64_t>& slot()						{ return s[ threadSlot() % shards ].v; }
+
+			ShardedAccumulator( const ShardedAccumulator& );
+			ShardedAccumulator& operator=( const ShardedAccumulator& );
+	};
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_ATOMIC_H
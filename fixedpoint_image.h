@@ -0,0 +1,441 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_IMAGE_H
+#define FIXEDPOINT_IMAGE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "fixedpoint.h"
+#include "fixedpoint_parallel.h"
+
+
+namespace fastmath
+{
+
+	/**
+	 *	Non-owning view over an interleaved image, stride is expressed
+	 *	in elements, not bytes.
+	 */
+	template<typename pixel_t>
+	struct Image
+	{
+		pixel_t*	pixels;
+		int32_t		width;
+		int32_t		height;
+		int32_t		stride;
+		int32_t		channels;
+
+		inline pixel_t* row( int32_t y ) const		{ return pixels + y * stride; }
+	};
+
+
+	/**
+	 *	Per-format constants: resampling weights carry WEIGHT_BITS fraction
+	 *	bits, as many as the pixels do, the vertical pass drops SHIFT bits
+	 *	and both passes accumulate in an accumulator_t.
+	 */
+	template<typename pixel_t> struct PixelInfo;
+
+	template<> struct PixelInfo<uint8_t>
+	{
+		enum { BITS =  8, MAX = 0xff, WEIGHT_BITS =  8, SHIFT = 0 };
+		typedef int32_t accumulator_t;
+	};
+
+	template<> struct PixelInfo<uint16_t>
+	{
+		enum { BITS = 16, MAX = 0xffff, WEIGHT_BITS = 16, SHIFT = 8 };
+		typedef int64_t accumulator_t;
+	};
+
+
+	enum { TILE_SIZE = 64 };
+
+
+	// local helpers
+
+	template<int32_t precision_bits, int32_t weight_bits>
+	inline int32_t toWeight( uint32_t fraction )
+	{
+		return int32_t( precision_bits >= weight_bits ? fraction >> ( precision_bits - weight_bits ) : fraction << ( weight_bits - precision_bits ) );
+	}
+
+	inline int32_t clampIndex( int32_t i, int32_t size )
+	{
+		return i < 0 ? 0 : ( i >= size ? size - 1 : i );
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Scanline stepping (DDA)
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Steps count times from start, splitting every position in its
+	 *	integer and fractional parts, as getInteger() / getFraction() would.
+	 *
+	 *	The loop works on the raw value only, so that it vectorizes.
+	 */
+	template<int32_t bits, template <int32_t> class mulP, template <int32_t> class divP>
+	void scanlineStep( const FixedPoint<bits, mulP, divP>& start, const FixedPoint<bits, mulP, divP>& step,
+					   int32_t count, int32_t* integers, uint32_t* fractions )
+	{
+		// unsigned, so that long spans wrap as the hand written loop would
+		uint32_t v = uint32_t( start.getRaw() );
+		uint32_t dv = uint32_t( step.getRaw() );
+
+		for( int32_t i = 0; i < count; ++i )
+		{
+			uint32_t r = v + uint32_t( i ) * dv;
+			integers[ i ] = int32_t( r ) >> bits;
+			fractions[ i ] = r & ( ( 1u << bits ) - 1 );
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Resampling
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Maps every destination sample onto its source taps, with pixel
+	 *	centers aligned; positions are kept as fixed16_t, each one rounded
+	 *	from the exact ratio so that no error builds up along a row, and the
+	 *	weights are taken from their fraction, with weight_bits bits.
+	 *
+	 *	The taps of a sample are consecutive, start receives the first one,
+	 *	not clamped to the source.
+	 */
+	template<int32_t taps, int32_t weight_bits>
+	void buildTaps( int32_t srcSize, int32_t dstSize, int32_t* start, int32_t* weight )
+	{
+		const int64_t one = int64_t( 1 ) << weight_bits;
+		const int64_t den = int64_t( dstSize ) * 4;
+
+		for( int32_t i = 0; i < dstSize; ++i )
+		{
+			// ( i + 0.5 ) * srcSize / dstSize - 0.5, rounded to the nearest fixed16_t
+			int64_t num = ( int64_t( 2 * i + 1 ) * srcSize - dstSize ) * ( 1 << 17 ) + den / 2;
+			int64_t raw = num / den - ( num % den < 0 );
+			fixed16_t pos = fixed16_t::fromRaw( int32_t( raw ) );
+
+			int64_t t = toWeight<16, weight_bits>( pos.getFraction() );
+			int32_t* w = weight + i * taps;
+
+			if( taps == 2 )
+			{
+				w[ 0 ] = int32_t( one - t );
+				w[ 1 ] = int32_t( t );
+			}
+			else
+			{
+				// Catmull-Rom
+				int64_t t2 = ( t * t ) >> weight_bits;
+				int64_t t3 = ( t2 * t ) >> weight_bits;
+				w[ 0 ] = int32_t( ( -t3 + 2 * t2 - t ) >> 1 );
+				w[ 2 ] = int32_t( ( -3 * t3 + 4 * t2 + t ) >> 1 );
+				w[ 3 ] = int32_t( ( t3 - t2 ) >> 1 );
+				w[ 1 ] = int32_t( one ) - w[ 0 ] - w[ 2 ] - w[ 3 ];
+			}
+
+			start[ i ] = pos.getInteger() - ( taps / 2 - 1 );
+		}
+	}
+
+	/**
+	 *	Vertical pass over count contiguous elements of the source rows,
+	 *	SHIFT bits are dropped from the result.
+	 */
+	template<int32_t taps, typename pixel_t>
+	inline void resampleVertical( const pixel_t* const* rows, const int32_t* weight, int32_t count, int32_t* out )
+	{
+		typedef typename PixelInfo<pixel_t>::accumulator_t accumulator_t;
+		enum { SHIFT = PixelInfo<pixel_t>::SHIFT };
+
+		// local copies, so that the stores can't alias them
+		const pixel_t* r[ taps ];
+		accumulator_t w[ taps ];
+		for( int32_t j = 0; j < taps; ++j )
+		{
+			r[ j ] = rows[ j ];
+			w[ j ] = weight[ j ];
+		}
+
+		for( int32_t k = 0; k < count; ++k )
+		{
+			accumulator_t acc = 0;
+			for( int32_t j = 0; j < taps; ++j )
+			{
+				acc += accumulator_t( r[ j ][ k ] ) * w[ j ];
+			}
+			out[ k ] = int32_t( ( acc + ( ( accumulator_t( 1 ) << SHIFT ) >> 1 ) ) >> SHIFT );
+		}
+	}
+
+	/**
+	 *	Horizontal pass over a transposed tile, where the taps are whole
+	 *	rows of count elements; rounds and clamps to the pixel range.
+	 */
+	template<int32_t taps, typename pixel_t>
+	inline void resampleHorizontal( const int32_t* in, const int32_t* weight, int32_t count, int32_t* out )
+	{
+		typedef typename PixelInfo<pixel_t>::accumulator_t accumulator_t;
+		enum { DROP = 2 * PixelInfo<pixel_t>::WEIGHT_BITS - PixelInfo<pixel_t>::SHIFT, MAX = PixelInfo<pixel_t>::MAX };
+
+		accumulator_t w[ taps ];
+		for( int32_t j = 0; j < taps; ++j )
+		{
+			w[ j ] = weight[ j ];
+		}
+
+		for( int32_t k = 0; k < count; ++k )
+		{
+			accumulator_t acc = 0;
+			for( int32_t j = 0; j < taps; ++j )
+			{
+				acc += in[ j * count + k ] * w[ j ];
+			}
+			acc = ( acc + ( accumulator_t( 1 ) << ( DROP - 1 ) ) ) >> DROP;
+			out[ k ] = int32_t( acc < 0 ? 0 : ( acc > MAX ? accumulator_t( MAX ) : acc ) );
+		}
+	}
+
+	/**
+	 *	Separable resampling core, walks the destination in tiles so the
+	 *	source rows touched by a tile stay in cache.
+	 *
+	 *	Every tile goes through a vertical pass over the source columns it
+	 *	needs, is transposed, and goes through the horizontal pass as if it
+	 *	were a vertical one: both inner loops run over contiguous elements,
+	 *	whatever the number of channels, so that they vectorize.
+	 *
+	 *	Nothing is written when either image is empty.
+	 */
+	template<int32_t taps, typename pixel_t>
+	void resample( const Image<pixel_t>& src, const Image<pixel_t>& dst, int32_t threads )
+	{
+		enum { WEIGHT_BITS = PixelInfo<pixel_t>::WEIGHT_BITS };
+
+		if( src.width <= 0 || src.height <= 0 || dst.width <= 0 || dst.height <= 0 )
+		{
+			return;
+		}
+
+		std::vector<int32_t> xs( dst.width ), xw( dst.width * taps );
+		std::vector<int32_t> ys( dst.height ), yw( dst.height * taps );
+		buildTaps<taps, WEIGHT_BITS>( src.width, dst.width, &xs[ 0 ], &xw[ 0 ] );
+		buildTaps<taps, WEIGHT_BITS>( src.height, dst.height, &ys[ 0 ], &yw[ 0 ] );
+
+		const int32_t ch = dst.channels;
+		const int32_t* xStart = &xs[ 0 ];
+		const int32_t* xWeight = &xw[ 0 ];
+		const int32_t* yStart = &ys[ 0 ];
+		const int32_t* yWeight = &yw[ 0 ];
+
+		parallelFor( size_t( dst.height ), threads, [&]( size_t y0, size_t y1 )
+		{
+			std::vector<int32_t> vertical, transposed, horizontal;
+
+			for( int32_t ty = int32_t( y0 ); ty < int32_t( y1 ); ty += TILE_SIZE )
+			{
+				const int32_t rows = ty + TILE_SIZE < int32_t( y1 ) ? TILE_SIZE : int32_t( y1 ) - ty;
+				const int32_t column = rows * ch;
+
+				for( int32_t tx = 0; tx < dst.width; tx += TILE_SIZE )
+				{
+					const int32_t cols = tx + TILE_SIZE < dst.width ? TILE_SIZE : dst.width - tx;
+
+					// source columns [s0, s1) touched by the tile, [lo, hi) once clamped
+					const int32_t s0 = xStart[ tx ];
+					const int32_t s1 = xStart[ tx + cols - 1 ] + taps;
+					const int32_t lo = s0 < 0 ? 0 : s0;
+					const int32_t hi = s1 > src.width ? src.width : s1;
+					const int32_t span = ( s1 - s0 ) * ch;
+
+					vertical.resize( size_t( rows ) * span );
+					transposed.resize( size_t( rows ) * span );
+					horizontal.resize( size_t( cols ) * column );
+
+					for( int32_t r = 0; r < rows; ++r )
+					{
+						const pixel_t* taprows[ taps ];
+						for( int32_t j = 0; j < taps; ++j )
+						{
+							taprows[ j ] = src.row( clampIndex( yStart[ ty + r ] + j, src.height ) ) + lo * ch;
+						}
+
+						int32_t* v = &vertical[ size_t( r ) * span ];
+						resampleVertical<taps>( taprows, yWeight + ( ty + r ) * taps, ( hi - lo ) * ch, v + ( lo - s0 ) * ch );
+
+						// columns past the borders repeat the border ones
+						for( int32_t x = s0; x < lo; ++x )
+						{
+							for( int32_t c = 0; c < ch; ++c ) v[ ( x - s0 ) * ch + c ] = v[ ( lo - s0 ) * ch + c ];
+						}
+						for( int32_t x = hi; x < s1; ++x )
+						{
+							for( int32_t c = 0; c < ch; ++c ) v[ ( x - s0 ) * ch + c ] = v[ ( hi - 1 - s0 ) * ch + c ];
+						}
+					}
+
+					// one row per source column, holding every destination row
+					for( int32_t r = 0; r < rows; ++r )
+					{
+						for( int32_t x = 0; x < s1 - s0; ++x )
+						{
+							for( int32_t c = 0; c < ch; ++c )
+							{
+								transposed[ x * column + r * ch + c ] = vertical[ size_t( r ) * span + x * ch + c ];
+							}
+						}
+					}
+
+					for( int32_t x = 0; x < cols; ++x )
+					{
+						resampleHorizontal<taps, pixel_t>( &transposed[ ( xStart[ tx + x ] - s0 ) * column ],
+														   xWeight + ( tx + x ) * taps, column, &horizontal[ x * column ] );
+					}
+
+					for( int32_t r = 0; r < rows; ++r )
+					{
+						pixel_t* out = dst.row( ty + r ) + tx * ch;
+						for( int32_t x = 0; x < cols; ++x )
+						{
+							for( int32_t c = 0; c < ch; ++c )
+							{
+								out[ x * ch + c ] = pixel_t( horizontal[ x * column + r * ch + c ] );
+							}
+						}
+					}
+				}
+			}
+		} );
+	}
+
+	/**
+	 *	Bilinear resampling of src into dst, both with the same number of
+	 *	channels; threads <= 0 uses every hardware thread.
+	 */
+	template<typename pixel_t>
+	inline void resampleBilinear( const Image<pixel_t>& src, const Image<pixel_t>& dst, int32_t threads = 0 )
+	{
+		resample<2>( src, dst, threads );
+	}
+
+	/**
+	 *	Bicubic (Catmull-Rom) resampling, results are clamped to the
+	 *	pixel range.
+	 */
+	template<typename pixel_t>
+	inline void resampleBicubic( const Image<pixel_t>& src, const Image<pixel_t>& dst, int32_t threads = 0 )
+	{
+		resample<4>( src, dst, threads );
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Alpha blending
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Blends a single row of CH channel pixels; with CH known at compile
+	 *	time the compiler vectorizes across pixels.
+	 */
+	template<int32_t CH, typename pixel_t>
+	inline void blendRow( const pixel_t* s, const pixel_t* a, pixel_t* d, int32_t width )
+	{
+		enum { BITS = PixelInfo<pixel_t>::BITS, MAX = PixelInfo<pixel_t>::MAX };
+
+		for( int32_t x = 0; x < width; ++x )
+		{
+			uint32_t w = a[ x ];
+			for( int32_t c = 0; c < CH; ++c )
+			{
+				uint32_t t = uint32_t( s[ x * CH + c ] ) * w + uint32_t( d[ x * CH + c ] ) * ( MAX - w ) + ( 1u << ( BITS - 1 ) );
+				d[ x * CH + c ] = pixel_t( ( t + ( t >> BITS ) ) >> BITS );
+			}
+		}
+	}
+
+	/**
+	 *	Any other channel count: the alpha row is first spread over every
+	 *	channel, then blended as a single channel row.
+	 */
+	template<typename pixel_t>
+	inline void blendRow( const pixel_t* s, const pixel_t* a, pixel_t* d, int32_t width, int32_t channels, pixel_t* spread )
+	{
+		for( int32_t x = 0; x < width; ++x )
+		{
+			for( int32_t c = 0; c < channels; ++c )
+			{
+				spread[ x * channels + c ] = a[ x ];
+			}
+		}
+
+		blendRow<1>( s, spread, d, width * channels );
+	}
+
+	/**
+	 *	dst = src * a + dst * ( 1 - a ), with a single channel alpha image
+	 *	and a rounded division by the pixel maximum.
+	 *
+	 *	One, two and four channels take a specialized row loop, three
+	 *	channels (which SSE can't deinterleave) and any other count go
+	 *	through a spread alpha row.
+	 */
+	template<typename pixel_t>
+	void alphaBlend( const Image<pixel_t>& src, const Image<pixel_t>& alpha, const Image<pixel_t>& dst, int32_t threads = 0 )
+	{
+		const int32_t ch = dst.channels;
+
+		parallelFor( size_t( dst.height ), threads, [&]( size_t y0, size_t y1 )
+		{
+			std::vector<pixel_t> spread;
+
+			for( int32_t y = int32_t( y0 ); y < int32_t( y1 ); ++y )
+			{
+				const pixel_t* s = src.row( y );
+				const pixel_t* a = alpha.row( y );
+				pixel_t* d = dst.row( y );
+
+				switch( ch )
+				{
+					case 1:		blendRow<1>( s, a, d, dst.width ); break;
+					case 2:		blendRow<2>( s, a, d, dst.width ); break;
+					case 4:		blendRow<4>( s, a, d, dst.width ); break;
+					default:
+						spread.resize( size_t( dst.width ) * ch );
+						blendRow( s, a, d, dst.width, ch, spread.empty() ? (pixel_t*)0 : &spread[ 0 ] );
+						break;
+				}
+			}
+		} );
+	}
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_IMAGE_H
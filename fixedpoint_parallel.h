@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_PARALLEL_H
+#define FIXEDPOINT_PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+
+
+namespace fastmath
+{
+
+	/**
+	 *	Splits [0, count) in contiguous ranges, one per thread, and calls
+	 *	job( begin, end ) on each; threads <= 0 means one per hardware thread.
+	 *
+	 *	The ranges only depend on count and on the number of threads, never
+	 *	on scheduling.
+	 */
+	template<class Job>
+	void parallelFor( size_t count, int32_t threads, Job job )
+	{
+		if( threads <= 0 )
+		{
+			threads = int32_t( std::thread::hardware_concurrency() );
+		}
+
+		if( size_t( threads ) > count ) threads = int32_t( count );
+		if( threads <= 1 )
+		{
+			job( size_t( 0 ), count );
+			return;
+		}
+
+		std::vector<std::thread> pool;
+		for( int32_t t = 0; t < threads; ++t )
+		{
+			pool.push_back( std::thread( job, count * t / threads, count * ( t + 1 ) / threads ) );
+		}
+
+		for( size_t t = 0; t < pool.size(); ++t )
+		{
+			pool[ t ].join();
+		}
+	}
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_PARALLEL_H
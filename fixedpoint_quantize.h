@@ -0,0 +1,295 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_QUANTIZE_H
+#define FIXEDPOINT_QUANTIZE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "fixedpoint.h"
+#include "fixedpoint_parallel.h"
+
+
+namespace fastmath
+{
+
+	/**
+	 *	Quantization of float data into raw FixedPoint values, where every
+	 *	block (or channel) carries its own precision_bits, picked from the
+	 *	observed range so that no value overflows the raw int32_t.
+	 *
+	 *	Everything works on caller-provided chunks: per-block formats need a
+	 *	single pass, per-channel ones a range pass (ChannelRange) followed by
+	 *	the quantization pass, so datasets larger than memory can be streamed
+	 *	through a fixed-size buffer.
+	 *
+	 *	A raw value r with b bits stands for r / 2^b, that is the raw value of
+	 *	a FixedPoint<b, ...>. The input is plain float, whatever float_t is.
+	 *
+	 *	Infinities saturate and don't take part in picking the precision,
+	 *	which only depends on the finite values. NaNs are not supported.
+	 */
+
+	enum { QUANTIZE_MAX_BITS = 30 };
+
+	static_assert( sizeof( float ) == sizeof( uint32_t ), "maxAbs() needs 32-bit floats" );
+
+
+	// local helpers
+
+	/**
+	 *	Largest precision that keeps maxAbs representable, clamped to
+	 *	[0, QUANTIZE_MAX_BITS]; larger values saturate.
+	 */
+	inline int8_t pickPrecision( float maxAbs )
+	{
+		if( maxAbs != maxAbs )
+		{
+			return 0;
+		}
+
+		if( !( maxAbs > 0 ) )
+		{
+			return QUANTIZE_MAX_BITS;
+		}
+
+		int32_t e;
+		frexpf( maxAbs, &e );			// maxAbs < 2^e
+		int32_t bits = 31 - e;
+		return int8_t( bits < 0 ? 0 : ( bits > QUANTIZE_MAX_BITS ? QUANTIZE_MAX_BITS : bits ) );
+	}
+
+	/**
+	 *	Round to nearest, ties away from zero, saturating. The half is
+	 *	added in double, where it can't round the sum up as it would in
+	 *	float (0.49999997f + 0.5f == 1.0f); written without branches and
+	 *	with plain compares so that the callers' loops vectorize.
+	 */
+	inline int32_t quantizeValue( float x, float scale )
+	{
+		double v = x * scale;			// exact, scale is a power of two
+		v += copysign( 0.5, v );
+		v = v < -2147483647.0 ? -2147483647.0 : v;
+		v = v >  2147483647.0 ?  2147483647.0 : v;
+		return int32_t( v );
+	}
+
+	/**
+	 *	Largest finite magnitude; compares the bit patterns, ordered as the
+	 *	magnitudes once the sign is masked off, so that it vectorizes where
+	 *	a float max doesn't. Infinities and NaNs count as zero.
+	 */
+	inline float maxAbs( const float* in, size_t count, size_t stride )
+	{
+		uint32_t m = 0;
+		for( size_t i = 0; i < count; ++i )
+		{
+			uint32_t b;
+			memcpy( &b, in + i * stride, sizeof( b ) );
+			b &= 0x7fffffffu;
+			b &= 0u - uint32_t( b < 0x7f800000u );	// drops infinities and NaNs
+			m = b > m ? b : m;
+		}
+
+		float r;
+		memcpy( &r, &m, sizeof( r ) );
+		return r;
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Per-block formats
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Quantizes count values, one precision per blockSize consecutive values;
+	 *	bits must hold ( count + blockSize - 1 ) / blockSize entries.
+	 *
+	 *	When streaming, use chunks that are a multiple of blockSize.
+	 */
+	inline void quantizeBlocks( const float* in, size_t count, size_t blockSize, int32_t* raw, int8_t* bits, int32_t threads = 0 )
+	{
+		size_t blocks = ( count + blockSize - 1 ) / blockSize;
+
+		parallelFor( blocks, threads, [=]( size_t b0, size_t b1 )
+		{
+			for( size_t b = b0; b < b1; ++b )
+			{
+				size_t at = b * blockSize;
+				size_t n = at + blockSize < count ? blockSize : count - at;
+
+				bits[ b ] = pickPrecision( maxAbs( in + at, n, 1 ) );
+				float scale = ldexpf( 1.0f, bits[ b ] );
+
+				for( size_t i = 0; i < n; ++i )
+				{
+					raw[ at + i ] = quantizeValue( in[ at + i ], scale );
+				}
+			}
+		} );
+	}
+
+	inline void dequantizeBlocks( const int32_t* raw, const int8_t* bits, size_t count, size_t blockSize, float* out, int32_t threads = 0 )
+	{
+		size_t blocks = ( count + blockSize - 1 ) / blockSize;
+
+		parallelFor( blocks, threads, [=]( size_t b0, size_t b1 )
+		{
+			for( size_t b = b0; b < b1; ++b )
+			{
+				size_t at = b * blockSize;
+				size_t n = at + blockSize < count ? blockSize : count - at;
+				float scale = ldexpf( 1.0f, -bits[ b ] );
+
+				for( size_t i = 0; i < n; ++i )
+				{
+					out[ at + i ] = float( raw[ at + i ] ) * scale;
+				}
+			}
+		} );
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Per-channel formats
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Range pass for interleaved data, feed it every chunk once and then
+	 *	read back the per-channel precisions.
+	 */
+	class ChannelRange
+	{
+		public:
+
+			explicit ChannelRange( int32_t channels ) : range( channels, 0.0f ) {}
+
+			/**
+			 *	count is expressed in whole samples, channels values each;
+			 *	the samples are split in one band per thread, whose maxima
+			 *	are merged afterwards.
+			 */
+			void scan( const float* in, size_t count, int32_t threads = 0 )
+			{
+				const size_t ch = range.size();
+				int32_t bands = threads > 0 ? threads : int32_t( std::thread::hardware_concurrency() );
+				if( bands < 1 ) bands = 1;
+
+				std::vector<float> found( bands * ch, 0.0f );
+
+				parallelFor( size_t( bands ), bands, [&]( size_t t0, size_t t1 )
+				{
+					for( size_t t = t0; t < t1; ++t )
+					{
+						size_t s0 = count * t / bands;
+						size_t s1 = count * ( t + 1 ) / bands;
+						for( size_t c = 0; c < ch; ++c )
+						{
+							found[ t * ch + c ] = maxAbs( in + s0 * ch + c, s1 - s0, ch );
+						}
+					}
+				} );
+
+				// a max, so the result doesn't depend on the number of bands
+				for( size_t i = 0; i < found.size(); ++i )
+				{
+					float& m = range[ i % ch ];
+					m = found[ i ] > m ? found[ i ] : m;
+				}
+			}
+
+			inline int32_t getChannels() const				{ return int32_t( range.size() ); }
+			inline float getMaxAbs( int32_t c ) const		{ return range[ c ]; }
+			inline int8_t getPrecision( int32_t c ) const	{ return pickPrecision( range[ c ] ); }
+
+			inline void getPrecisions( int8_t* bits ) const
+			{
+				for( size_t c = 0; c < range.size(); ++c )
+				{
+					bits[ c ] = pickPrecision( range[ c ] );
+				}
+			}
+
+
+		private:
+
+			std::vector<float> range;
+	};
+
+	/**
+	 *	Quantizes count interleaved samples, channels values each, using
+	 *	one precision per channel.
+	 */
+	inline void quantizeChannels( const float* in, size_t count, int32_t channels, const int8_t* bits, int32_t* raw, int32_t threads = 0 )
+	{
+		std::vector<float> scales( channels );
+		for( int32_t c = 0; c < channels; ++c )
+		{
+			scales[ c ] = ldexpf( 1.0f, bits[ c ] );
+		}
+
+		const float* scale = &scales[ 0 ];
+
+		parallelFor( count, threads, [=]( size_t s0, size_t s1 )
+		{
+			for( size_t s = s0; s < s1; ++s )
+			{
+				for( int32_t c = 0; c < channels; ++c )
+				{
+					raw[ s * channels + c ] = quantizeValue( in[ s * channels + c ], scale[ c ] );
+				}
+			}
+		} );
+	}
+
+	inline void dequantizeChannels( const int32_t* raw, size_t count, int32_t channels, const int8_t* bits, float* out, int32_t threads = 0 )
+	{
+		std::vector<float> scales( channels );
+		for( int32_t c = 0; c < channels; ++c )
+		{
+			scales[ c ] = ldexpf( 1.0f, -bits[ c ] );
+		}
+
+		const float* scale = &scales[ 0 ];
+
+		parallelFor( count, threads, [=]( size_t s0, size_t s1 )
+		{
+			for( size_t s = s0; s < s1; ++s )
+			{
+				for( int32_t c = 0; c < channels; ++c )
+				{
+					out[ s * channels + c ] = float( raw[ s * channels + c ] ) * scale[ c ];
+				}
+			}
+		} );
+	}
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_QUANTIZE_H
@@ -0,0 +1,388 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_SIM_H
+#define FIXEDPOINT_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "fixedpoint.h"
+#include "fixedpoint_parallel.h"
+#include "fixedpoint_sort.h"
+
+
+namespace fastmath
+{
+
+	/**
+	 *	Deterministic simulation core for lockstep use.
+	 *
+	 *	Everything is integer arithmetic on FixedPoint values, every body is
+	 *	updated from its own state only and the broadphase output is ordered
+	 *	by body index, so results are bit-exact across machines and across
+	 *	thread counts.
+	 */
+
+
+	/**
+	 *	Structure-of-arrays body storage (2D).
+	 */
+	template<class Fixed>
+	struct BodySet
+	{
+		std::vector<Fixed>	px, py;
+		std::vector<Fixed>	vx, vy;
+		std::vector<Fixed>	radius;
+
+		inline size_t size() const		{ return px.size(); }
+
+		inline size_t add( const Fixed& x, const Fixed& y, const Fixed& velX, const Fixed& velY, const Fixed& r )
+		{
+			px.push_back( x ); py.push_back( y );
+			vx.push_back( velX ); vy.push_back( velY );
+			radius.push_back( r );
+			return px.size() - 1;
+		}
+	};
+
+
+	/**
+	 *	Same acceleration for every body, such as gravity; any functor with
+	 *	this signature works with the integrators.
+	 */
+	template<class Fixed>
+	struct ConstantAcceleration
+	{
+		Fixed ax, ay;
+
+		inline void operator()( const Fixed&, const Fixed&, const Fixed&, const Fixed&, Fixed& outX, Fixed& outY ) const
+		{
+			outX = ax;
+			outY = ay;
+		}
+	};
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Integrators
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Semi-implicit Euler: velocity first, then position.
+	 */
+	template<class Fixed, class Accel>
+	void integrateEuler( BodySet<Fixed>& b, const Accel& accel, const Fixed& dt, int32_t threads = 0 )
+	{
+		parallelFor( b.size(), threads, [&]( size_t i0, size_t i1 )
+		{
+			for( size_t i = i0; i < i1; ++i )
+			{
+				Fixed ax, ay;
+				accel( b.px[ i ], b.py[ i ], b.vx[ i ], b.vy[ i ], ax, ay );
+				b.vx[ i ] += ax * dt;
+				b.vy[ i ] += ay * dt;
+				b.px[ i ] += b.vx[ i ] * dt;
+				b.py[ i ] += b.vy[ i ] * dt;
+			}
+		} );
+	}
+
+	/**
+	 *	Velocity Verlet, evaluates the acceleration twice per step.
+	 */
+	template<class Fixed, class Accel>
+	void integrateVerlet( BodySet<Fixed>& b, const Accel& accel, const Fixed& dt, int32_t threads = 0 )
+	{
+		parallelFor( b.size(), threads, [&]( size_t i0, size_t i1 )
+		{
+			Fixed halfDt = dt / 2;
+
+			for( size_t i = i0; i < i1; ++i )
+			{
+				Fixed ax, ay, nx, ny;
+				accel( b.px[ i ], b.py[ i ], b.vx[ i ], b.vy[ i ], ax, ay );
+				b.px[ i ] += ( b.vx[ i ] + ax * halfDt ) * dt;
+				b.py[ i ] += ( b.vy[ i ] + ay * halfDt ) * dt;
+				accel( b.px[ i ], b.py[ i ], b.vx[ i ], b.vy[ i ], nx, ny );
+				b.vx[ i ] += ( ax + nx ) * halfDt;
+				b.vy[ i ] += ( ay + ny ) * halfDt;
+			}
+		} );
+	}
+
+	/**
+	 *	Classic fourth order Runge-Kutta on ( position, velocity ).
+	 */
+	template<class Fixed, class Accel>
+	void integrateRK4( BodySet<Fixed>& b, const Accel& accel, const Fixed& dt, int32_t threads = 0 )
+	{
+		parallelFor( b.size(), threads, [&]( size_t i0, size_t i1 )
+		{
+			Fixed halfDt = dt / 2;
+			Fixed sixthDt = dt / 6;
+
+			for( size_t i = i0; i < i1; ++i )
+			{
+				Fixed x = b.px[ i ], y = b.py[ i ], u = b.vx[ i ], v = b.vy[ i ];
+				Fixed a1x, a1y, a2x, a2y, a3x, a3y, a4x, a4y;
+
+				accel( x, y, u, v, a1x, a1y );
+
+				Fixed u2 = u + a1x * halfDt, v2 = v + a1y * halfDt;
+				accel( x + u * halfDt, y + v * halfDt, u2, v2, a2x, a2y );
+
+				Fixed u3 = u + a2x * halfDt, v3 = v + a2y * halfDt;
+				accel( x + u2 * halfDt, y + v2 * halfDt, u3, v3, a3x, a3y );
+
+				Fixed u4 = u + a3x * dt, v4 = v + a3y * dt;
+				accel( x + u3 * dt, y + v3 * dt, u4, v4, a4x, a4y );
+
+				b.px[ i ] += ( u + 2 * u2 + 2 * u3 + u4 ) * sixthDt;
+				b.py[ i ] += ( v + 2 * v2 + 2 * v3 + v4 ) * sixthDt;
+				b.vx[ i ] += ( a1x + 2 * a2x + 2 * a3x + a4x ) * sixthDt;
+				b.vy[ i ] += ( a1y + 2 * a2y + 2 * a3y + a4y ) * sixthDt;
+			}
+		} );
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Broadphase
+	///////////////////////////////////////////////////////////////////////
+
+	struct BodyPair
+	{
+		uint32_t a, b;
+	};
+
+
+	/**
+	 *	Uniform grid broadphase, cells are keyed by the position over the
+	 *	cell size, rounded down.
+	 *
+	 *	The cell size must be at least the largest body diameter and the
+	 *	world must stay within 32768 cells from the origin on each axis.
+	 */
+	template<class Fixed>
+	class UniformGrid
+	{
+		public:
+
+			explicit UniformGrid( const Fixed& cellSize ) : cellSize( cellSize ) {}
+
+			/**
+			 *	Buckets every body, sorting them by cell; stable, so bodies
+			 *	sharing a cell stay in index order.
+			 */
+			void build( const BodySet<Fixed>& b, int32_t threads = 0 )
+			{
+				const size_t n = b.size();
+				keys.resize( n );
+				order.resize( n );
+
+				parallelFor( n, threads, [&]( size_t i0, size_t i1 )
+				{
+					for( size_t i = i0; i < i1; ++i )
+					{
+						keys[ i ] = Fixed::fromRaw( cellKey( cellOf( b.px[ i ] ), cellOf( b.py[ i ] ) ) );
+						order[ i ] = uint32_t( i );
+					}
+				} );
+
+				// keys ride on Fixed's raw value, so radixSort applies
+				if( n )
+				{
+					radixSort( &keys[ 0 ], &order[ 0 ], n );
+				}
+
+				sorted.resize( n );
+				for( size_t i = 0; i < n; ++i )
+				{
+					sorted[ i ] = keys[ i ].getRaw();
+				}
+			}
+
+			/**
+			 *	Collects every overlapping pair, a < b, ordered by a and then by
+			 *	b's position in the grid; the order doesn't depend on threads.
+			 */
+			void findPairs( const BodySet<Fixed>& b, std::vector<BodyPair>& pairs, int32_t threads = 0 )
+			{
+				const size_t n = b.size();
+				int32_t bands = threads > 0 ? threads : int32_t( std::thread::hardware_concurrency() );
+				if( bands < 1 ) bands = 1;
+
+				std::vector< std::vector<BodyPair> > found( bands );
+
+				parallelFor( size_t( bands ), bands, [&]( size_t t0, size_t t1 )
+				{
+					for( size_t t = t0; t < t1; ++t )
+					{
+						for( size_t i = n * t / bands; i < n * ( t + 1 ) / bands; ++i )
+						{
+							collect( b, uint32_t( i ), found[ t ] );
+						}
+					}
+				} );
+
+				pairs.clear();
+				for( int32_t t = 0; t < bands; ++t )
+				{
+					pairs.insert( pairs.end(), found[ t ].begin(), found[ t ].end() );
+				}
+			}
+
+
+		private:
+
+			Fixed cellSize;
+			std::vector<Fixed> keys;
+			std::vector<uint32_t> order;
+			std::vector<int32_t> sorted;
+
+			/**
+			 *	floor( p / cellSize ), exact: both raw values share the same
+			 *	precision bits, so plain integer division on them gives the
+			 *	cell, rounded down where the quotient is negative.
+			 */
+			inline int32_t cellOf( const Fixed& p ) const
+			{
+				int32_t r = p.getRaw();
+				int32_t c = cellSize.getRaw();
+				int32_t q = r / c;
+				return q - int32_t( r % c != 0 && ( r < 0 ) != ( c < 0 ) );
+			}
+
+			inline static int32_t cellKey( int32_t cx, int32_t cy )
+			{
+				return int32_t( uint32_t( cy ) << 16 ) | ( ( cx + 32768 ) & 0xffff );
+			}
+
+			void collect( const BodySet<Fixed>& b, uint32_t i, std::vector<BodyPair>& out ) const
+			{
+				int32_t cx = cellOf( b.px[ i ] );
+				int32_t cy = cellOf( b.py[ i ] );
+
+				for( int32_t dy = -1; dy <= 1; ++dy )
+				{
+					// the three cells of a row have consecutive keys, unless cx wraps
+					int32_t first = cellKey( cx - 1, cy + dy );
+					int32_t last = cellKey( cx + 1, cy + dy );
+
+					if( last - first == 2 )
+					{
+						collect( b, i, first, last, out );
+					}
+					else
+					{
+						for( int32_t dx = -1; dx <= 1; ++dx )
+						{
+							int32_t key = cellKey( cx + dx, cy + dy );
+							collect( b, i, key, key, out );
+						}
+					}
+				}
+			}
+
+			/**
+			 *	Tests i against the bodies with keys in [first, last].
+			 */
+			void collect( const BodySet<Fixed>& b, uint32_t i, int32_t first, int32_t last, std::vector<BodyPair>& out ) const
+			{
+				std::vector<int32_t>::const_iterator at = std::lower_bound( sorted.begin(), sorted.end(), first );
+
+				for( ; at != sorted.end() && *at <= last; ++at )
+				{
+					uint32_t j = order[ at - sorted.begin() ];
+					if( j > i && overlap( b, i, j ) )
+					{
+						BodyPair p = { i, j };
+						out.push_back( p );
+					}
+				}
+			}
+
+			/**
+			 *	Exact test on the raw values. dx and dy reach 2^32, so the sum
+			 *	of their squares doesn't fit 64 bits: pairs farther than r apart
+			 *	on either axis are rejected first, then dx^2 < r^2 - dy^2 is
+			 *	evaluated in uint64_t, where |dx|, |dy| < r < 2^32 keep every
+			 *	term in range. Radii are taken as non-negative.
+			 */
+			inline static bool_t overlap( const BodySet<Fixed>& b, uint32_t i, uint32_t j )
+			{
+				int64_t dx = int64_t( b.px[ i ].getRaw() ) - b.px[ j ].getRaw();
+				int64_t dy = int64_t( b.py[ i ].getRaw() ) - b.py[ j ].getRaw();
+				int64_t r = int64_t( b.radius[ i ].getRaw() ) + b.radius[ j ].getRaw();
+
+				uint64_t ax = uint64_t( dx < 0 ? -dx : dx );
+				uint64_t ay = uint64_t( dy < 0 ? -dy : dy );
+				if( r <= 0 || ax >= uint64_t( r ) || ay >= uint64_t( r ) )
+				{
+					return false;
+				}
+
+				uint64_t r2 = uint64_t( r ) * uint64_t( r );
+				return ax * ax < r2 - ay * ay;
+			}
+	};
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Replay support
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	FNV-1a over every raw value, for comparing lockstep peers or
+	 *	replays bit by bit.
+	 */
+	template<class Fixed>
+	uint64_t stateHash( const BodySet<Fixed>& b )
+	{
+		uint64_t h = 14695981039346656037ull;
+		const std::vector<Fixed>* fields[] = { &b.px, &b.py, &b.vx, &b.vy, &b.radius };
+
+		for( size_t f = 0; f < sizeof( fields ) / sizeof( fields[ 0 ] ); ++f )
+		{
+			for( size_t i = 0; i < fields[ f ]->size(); ++i )
+			{
+				uint32_t raw = uint32_t( ( *fields[ f ] )[ i ].getRaw() );
+				for( int32_t k = 0; k < 4; ++k )
+				{
+					h ^= ( raw >> ( k << 3 ) ) & 0xff;
+					h *= 1099511628211ull;
+				}
+			}
+		}
+
+		return h;
+	}
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_SIM_H
@@ -0,0 +1,234 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_SORT_H
+#define FIXEDPOINT_SORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "fixedpoint.h"
+
+
+namespace fastmath
+{
+
+	// local helpers
+
+	/**
+	 *	Maps a raw value onto an unsigned key with the same ordering,
+	 *	by flipping the sign bit.
+	 */
+	inline uint32_t sortKey( int32_t raw )		{ return uint32_t( raw ) ^ 0x80000000u; }
+
+
+	///////////////////////////////////////////////////////////////////////
+	// LSD radix sort
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Shared by the plain and key-value sorts, values may be null.
+	 */
+	template<class Fixed, class Value>
+	void radixSortPasses( Fixed* data, size_t count, Fixed* scratch, Value* values, Value* valueScratch )
+	{
+		size_t hist[ 4 ][ 256 ] = {};
+
+		for( size_t i = 0; i < count; ++i )
+		{
+			uint32_t k = sortKey( data[ i ].getRaw() );
+			++hist[ 0 ][ k & 0xff ];
+			++hist[ 1 ][ ( k >> 8 ) & 0xff ];
+			++hist[ 2 ][ ( k >> 16 ) & 0xff ];
+			++hist[ 3 ][ k >> 24 ];
+		}
+
+		Fixed* src = data;
+		Fixed* dst = scratch;
+		Value* vsrc = values;
+		Value* vdst = valueScratch;
+
+		for( int32_t pass = 0; pass < 4; ++pass )
+		{
+			int32_t shift = pass << 3;
+			size_t* h = hist[ pass ];
+
+			if( count == 0 || h[ ( sortKey( src[ 0 ].getRaw() ) >> shift ) & 0xff ] == count )
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for( int32_t d = 0; d < 256; ++d )
+			{
+				size_t tmp = h[ d ];
+				h[ d ] = offset;
+				offset += tmp;
+			}
+
+			for( size_t i = 0; i < count; ++i )
+			{
+				size_t at = h[ ( sortKey( src[ i ].getRaw() ) >> shift ) & 0xff ]++;
+				dst[ at ] = src[ i ];
+				if( values ) vdst[ at ] = vsrc[ i ];
+			}
+
+			Fixed* t = src; src = dst; dst = t;
+			Value* vt = vsrc; vsrc = vdst; vdst = vt;
+		}
+
+		if( src != data )
+		{
+			for( size_t i = 0; i < count; ++i )
+			{
+				data[ i ] = src[ i ];
+				if( values ) values[ i ] = vsrc[ i ];
+			}
+		}
+	}
+
+	/**
+	 *	Sorts count FixedPoint values in ascending order, four 8-bit passes
+	 *	over the raw value, never calling the comparison operators.
+	 *
+	 *	The scratch buffer must hold count elements; passes where every key
+	 *	shares the same digit are skipped. Stable.
+	 */
+	template<class Fixed>
+	void radixSort( Fixed* data, size_t count, Fixed* scratch )
+	{
+		radixSortPasses( data, count, scratch, (char*)0, (char*)0 );
+	}
+
+	/**
+	 *	Key-value variant, values are permuted along with their keys.
+	 */
+	template<class Fixed, class Value>
+	void radixSort( Fixed* keys, Value* values, size_t count, Fixed* keyScratch, Value* valueScratch )
+	{
+		radixSortPasses( keys, count, keyScratch, values, valueScratch );
+	}
+
+	/**
+	 *	Allocating versions
+	 */
+	template<class Fixed>
+	void radixSort( Fixed* data, size_t count )
+	{
+		std::vector<Fixed> scratch( count );
+		radixSort( data, count, count ? &scratch[ 0 ] : (Fixed*)0 );
+	}
+
+	template<class Fixed, class Value>
+	void radixSort( Fixed* keys, Value* values, size_t count )
+	{
+		std::vector<Fixed> keyScratch( count );
+		std::vector<Value> valueScratch( count );
+		if( count )
+		{
+			radixSort( keys, values, count, &keyScratch[ 0 ], &valueScratch[ 0 ] );
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Eytzinger search index
+	///////////////////////////////////////////////////////////////////////
+
+	/**
+	 *	Read-only lower_bound index over a sorted FixedPoint table.
+	 *
+	 *	Raw values are stored in breadth-first (Eytzinger) order, so the top
+	 *	levels of the implicit tree share the same few cache lines and the
+	 *	descent has no unpredictable branches; the next levels get prefetched
+	 *	where the compiler allows it.
+	 */
+	template<class Fixed>
+	class FixedPointIndex
+	{
+		public:
+
+			/**
+			 *	The table must be sorted in ascending order.
+			 */
+			FixedPointIndex( const Fixed* sorted, size_t count )
+				: n( count ), keys( count + 1 ), ranks( count + 1 )
+			{
+				size_t i = 0;
+				build( sorted, i, 1 );
+			}
+
+			inline size_t size() const		{ return n; }
+
+			/**
+			 *	Gives access to the position, in the original table, of the
+			 *	first element not less than x, or size() if there's none.
+			 */
+			inline size_t lowerBound( const Fixed& x ) const
+			{
+				int32_t r = x.getRaw();
+#if defined( __GNUC__ )
+				uintptr_t base = uintptr_t( keys.data() );
+#endif
+				size_t k = 1;
+				while( k <= n )
+				{
+#if defined( __GNUC__ )
+					// may point past the end, so the address never goes through a pointer
+					__builtin_prefetch( (const void*)( base + ( k << 4 ) * sizeof( int32_t ) ) );
+#endif
+					k = ( k << 1 ) + ( keys[ k ] < r );
+				}
+
+				// drop the trailing right turns, then the last left one
+				while( k & 1 ) k >>= 1;
+				k >>= 1;
+
+				return k ? ranks[ k ] : n;
+			}
+
+
+		private:
+
+			size_t n;
+			std::vector<int32_t> keys;
+			std::vector<size_t> ranks;
+
+			void build( const Fixed* sorted, size_t& i, size_t k )
+			{
+				if( k <= n )
+				{
+					build( sorted, i, k << 1 );
+					keys[ k ] = sorted[ i ].getRaw();
+					ranks[ k ] = i++;
+					build( sorted, i, ( k << 1 ) + 1 );
+				}
+			}
+	};
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_SORT_H
@@ -0,0 +1,344 @@
+/**
+ * Copyright (c) 2006 Manuel Bua
+ *
+ * THIS SOFTWARE IS PROVIDED 'AS-IS', WITHOUT ANY EXPRESS OR IMPLIED
+ * WARRANTY. IN NO EVENT WILL THE AUTHORS BE HELD LIABLE FOR ANY DAMAGES
+ * ARISING FROM THE USE OF THIS SOFTWARE.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *     1. The origin of this software must not be misrepresented; you must not
+ *     claim that you wrote the original software. If you use this software
+ *     in a product, an acknowledgment in the product documentation would be
+ *     appreciated but is not required.
+ *
+ *     2. Altered source versions must be plainly marked as such, and must not
+ *     be misrepresented as being the original software.
+ *
+ *     3. This notice may not be removed or altered from any source
+ *     distribution.
+ *
+ */
+
+#ifndef FIXEDPOINT_TUNE_H
+#define FIXEDPOINT_TUNE_H
+
+#include <stdint.h>
+#include <math.h>
+#include <ctype.h>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <ostream>
+
+#include "fixedpoint.h"
+
+
+namespace fastmath
+{
+
+	/**
+	 *	Lists of candidates to try, see PolicyTuner::run().
+	 */
+	template<int32_t... bits> struct BitsList {};
+	template<template <int32_t> class... policies> struct PolicyList {};
+
+
+	/**
+	 *	Printable name of a precision policy, as emitHeader() writes it;
+	 *	specialize it for your own policies, tuning one that has no name
+	 *	doesn't compile.
+	 */
+	template<template <int32_t> class Policy>
+	struct PolicyName
+	{
+		static_assert( sizeof( Policy<16> ) == 0, "specialize PolicyName for every policy given to PolicyTuner" );
+	};
+
+	template<> struct PolicyName<HighPrecision>	{ static const char* get() { return "HighPrecision"; } };
+	template<> struct PolicyName<MidPrecision>	{ static const char* get() { return "MidPrecision"; } };
+	template<> struct PolicyName<LowPrecision>	{ static const char* get() { return "LowPrecision"; } };
+
+
+	/**
+	 *	Outcome of a single FixedPoint configuration; groupSamplesPerSecond
+	 *	is the best throughput among the configurations with the same
+	 *	errors, the one the frontier and the recommendation use.
+	 */
+	struct TuneResult
+	{
+		int32_t			bits;
+		const char*		mulPolicy;
+		const char*		divPolicy;
+		double			samplesPerSecond;
+		double			groupSamplesPerSecond;
+		long double		maxError;
+		long double		rmsError;
+		bool_t			pareto;
+	};
+
+
+	/**
+	 *	Accuracy-vs-speed autotuner.
+	 *
+	 *	Runs a kernel over real, sampled inputs for every combination of
+	 *	precision bits and mul / div policies, measuring its throughput and
+	 *	its max / RMS error against a long double run of the same kernel.
+	 *
+	 *	The kernel is any functor callable with a pointer to its arguments,
+	 *	for every Number type involved:
+	 *
+	 *		struct Lerp {
+	 *			template<class Number>
+	 *			Number operator()( const Number* a ) const { return a[0] + ( a[1] - a[0] ) * a[2]; }
+	 *		};
+	 *
+	 *	Samples are laid out one call after another, arity values each, and
+	 *	are copied.
+	 *
+	 *	Throughput is the best of TIMING_RUNS runs. Configurations with the
+	 *	same max and RMS error are told apart by their order in the lists
+	 *	given to run(), never by timing noise: the earlier one wins, so list
+	 *	the preferred (or default) bits and policies first.
+	 */
+	template<class Kernel>
+	class PolicyTuner
+	{
+		public:
+
+			enum { TIMING_RUNS = 5 };
+
+			PolicyTuner( const Kernel& kernel, int32_t arity, const std::vector<long double>& samples, double minSeconds = 0.01 )
+				: kernel( kernel ), arity( arity ), samples( samples ), minSeconds( minSeconds )
+			{
+				calls = arity > 0 ? samples.size() / arity : 0;
+				reference.resize( calls );
+				for( size_t i = 0; i < calls; ++i )
+				{
+					reference[ i ] = kernel( &samples[ i * arity ] );
+				}
+			}
+
+			/**
+			 *	Measures every bits x mul policy x div policy combination.
+			 */
+			template<int32_t... bits, template <int32_t> class... policies>
+			void run( BitsList<bits...>, PolicyList<policies...> )
+			{
+				int32_t expand[] = { 0, ( measureMul<bits, policies...>(), 0 )... };
+				(void)expand;
+			}
+
+			/**
+			 *	Measures a single configuration.
+			 */
+			template<int32_t bits, template <int32_t> class mulP, template <int32_t> class divP>
+			void measure()
+			{
+				typedef FixedPoint<bits, mulP, divP> fixed_type;
+
+				std::vector<fixed_type> in( samples.size() );
+				std::vector<fixed_type> out( calls );
+				for( size_t i = 0; i < samples.size(); ++i )
+				{
+					in[ i ] = fixed_type( double_t( samples[ i ] ) );
+				}
+
+				// accuracy
+				TuneResult r = { bits, PolicyName<mulP>::get(), PolicyName<divP>::get(), 0, 0, 0, 0, false };
+				long double sq = 0;
+				for( size_t i = 0; i < calls; ++i )
+				{
+					out[ i ] = kernel( &in[ i * arity ] );
+					long double e = fabsl( ldexpl( (long double)out[ i ].getRaw(), -bits ) - reference[ i ] );
+					if( e > r.maxError ) r.maxError = e;
+					sq += e * e;
+				}
+				r.rmsError = calls ? sqrtl( sq / calls ) : 0;
+
+				// throughput, every run repeats the whole set until minSeconds are spent
+				typedef std::chrono::steady_clock clock;
+				volatile int32_t sink = 0;
+				for( int32_t run = 0; run < TIMING_RUNS; ++run )
+				{
+					size_t done = 0;
+					clock::time_point start = clock::now();
+					double elapsed = 0;
+					do
+					{
+						int32_t acc = 0;
+						for( size_t i = 0; i < calls; ++i )
+						{
+							acc ^= kernel( &in[ i * arity ] ).getRaw();
+						}
+						sink = sink ^ acc;
+						done += calls;
+						elapsed = std::chrono::duration<double>( clock::now() - start ).count();
+					}
+					while( calls && elapsed < minSeconds );
+
+					double rate = elapsed > 0 ? done / elapsed : 0;
+					if( rate > r.samplesPerSecond ) r.samplesPerSecond = rate;
+				}
+
+				results.push_back( r );
+				markPareto();
+			}
+
+			inline const std::vector<TuneResult>& getResults() const		{ return results; }
+
+			/**
+			 *	Gives access to the fastest configuration on the Pareto
+			 *	frontier whose max error stays within tolerance, or null.
+			 *
+			 *	Candidates are ranked by groupSamplesPerSecond, as the frontier
+			 *	is; those within SPEED_MARGIN of each other count as equally
+			 *	fast, the more accurate one wins, then the earlier one.
+			 */
+			const TuneResult* recommend( long double tolerance ) const
+			{
+				const double SPEED_MARGIN = 1.05;
+				const TuneResult* best = 0;
+				for( size_t i = 0; i < results.size(); ++i )
+				{
+					const TuneResult& r = results[ i ];
+					if( !r.pareto || r.maxError > tolerance )
+					{
+						continue;
+					}
+
+					if( !best || r.groupSamplesPerSecond > best->groupSamplesPerSecond * SPEED_MARGIN ||
+						( r.groupSamplesPerSecond * SPEED_MARGIN >= best->groupSamplesPerSecond && r.maxError < best->maxError ) )
+					{
+						best = &r;
+					}
+				}
+				return best;
+			}
+
+			void report( std::ostream& out ) const
+			{
+				out << "bits\tmul\t\tdiv\t\tsamples/s\tgroup samples/s\tmax error\trms error\n";
+				for( size_t i = 0; i < results.size(); ++i )
+				{
+					const TuneResult& r = results[ i ];
+					out << r.bits << '\t' << r.mulPolicy << '\t' << r.divPolicy << '\t'
+						<< r.samplesPerSecond << '\t' << r.groupSamplesPerSecond << '\t'
+						<< (double)r.maxError << '\t' << (double)r.rmsError
+						<< ( r.pareto ? "\t*" : "" ) << '\n';
+				}
+			}
+
+			/**
+			 *	Writes a header defining typeName as the recommended
+			 *	configuration, returns false if none fits the tolerance.
+			 */
+			bool_t emitHeader( std::ostream& out, const char* typeName, long double tolerance ) const
+			{
+				const TuneResult* r = recommend( tolerance );
+				if( !r )
+				{
+					return false;
+				}
+
+				// include guard from the type name, lerp_fixed_t -> LERP_FIXED_T_H
+				std::string guard;
+				for( const char* c = typeName; *c; ++c )
+				{
+					guard += isalnum( (unsigned char)*c ) ? char( toupper( (unsigned char)*c ) ) : '_';
+				}
+				guard += "_H";
+
+				out << "// Generated by fastmath::PolicyTuner, do not edit.\n"
+					<< "// max error " << (double)r->maxError << ", rms error " << (double)r->rmsError
+					<< ", " << r->groupSamplesPerSecond << " samples/s\n\n"
+					<< "#ifndef " << guard << "\n"
+					<< "#define " << guard << "\n\n"
+					<< "#include \"fixedpoint.h\"\n\n"
+					<< "namespace fastmath\n{\n"
+					<< "\ttypedef FixedPoint< " << r->bits << ", " << r->mulPolicy << ", " << r->divPolicy << " > " << typeName << ";\n"
+					<< "}\n\n"
+					<< "#endif\t// " << guard << "\n";
+				return true;
+			}
+
+
+		private:
+
+			Kernel kernel;
+			int32_t arity;
+			std::vector<long double> samples;
+			double minSeconds;
+			size_t calls;
+			std::vector<long double> reference;
+			std::vector<TuneResult> results;
+
+			template<int32_t bits, template <int32_t> class mulP, template <int32_t> class... policies>
+			void measureDiv()
+			{
+				int32_t expand[] = { 0, ( measure<bits, mulP, policies>(), 0 )... };
+				(void)expand;
+			}
+
+			template<int32_t bits, template <int32_t> class... policies>
+			void measureMul()
+			{
+				int32_t expand[] = { 0, ( measureDiv<bits, policies, policies...>(), 0 )... };
+				(void)expand;
+			}
+
+			/**
+			 *	A configuration is on the frontier if no other one is at least
+			 *	as fast and as accurate, and strictly better in one of the two.
+			 *
+			 *	Configurations with the same max and RMS error compete as one,
+			 *	as fast as the fastest of them (groupSamplesPerSecond), and
+			 *	only the earliest is kept.
+			 */
+			void markPareto()
+			{
+				for( size_t i = 0; i < results.size(); ++i )
+				{
+					TuneResult& r = results[ i ];
+					r.groupSamplesPerSecond = r.samplesPerSecond;
+					for( size_t j = 0; j < results.size(); ++j )
+					{
+						if( sameError( r, results[ j ] ) && results[ j ].samplesPerSecond > r.groupSamplesPerSecond )
+						{
+							r.groupSamplesPerSecond = results[ j ].samplesPerSecond;
+						}
+					}
+				}
+
+				for( size_t i = 0; i < results.size(); ++i )
+				{
+					TuneResult& r = results[ i ];
+					r.pareto = true;
+					for( size_t j = 0; j < results.size() && r.pareto; ++j )
+					{
+						const TuneResult& o = results[ j ];
+						if( sameError( o, r ) )
+						{
+							r.pareto = j >= i;
+						}
+						else if( o.groupSamplesPerSecond >= r.groupSamplesPerSecond && o.maxError <= r.maxError &&
+								 ( o.groupSamplesPerSecond > r.groupSamplesPerSecond || o.maxError < r.maxError ) )
+						{
+							r.pareto = false;
+						}
+					}
+				}
+			}
+
+			inline static bool_t sameError( const TuneResult& a, const TuneResult& b )
+			{
+				return a.maxError == b.maxError && a.rmsError == b.rmsError;
+			}
+	};
+
+}	// end of namespace fastmath
+
+
+#endif	// FIXEDPOINT_TUNE_H
@@ -0,0 +1,244 @@
+/**
+ *	Reads the assembly generated from kernels.cpp and compares every
+ *	FixedPoint kernel against its raw int32_t twin: fails when the
+ *	wrapper takes more instructions or more branches, or calls or jumps
+ *	out of the function, prints both listings when they don't hold the
+ *	same instructions (scheduling alone doesn't count).
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+
+typedef std::vector<std::string> Listing;
+
+
+// local helpers
+
+static std::string trim( const std::string& s )
+{
+	size_t b = s.find_first_not_of( " \t" );
+	size_t e = s.find_last_not_of( " \t\r" );
+	return b == std::string::npos ? std::string() : s.substr( b, e - b + 1 );
+}
+
+/**
+ *	Local labels get numbered per file, drop the numbers so that jumps
+ *	compare equal across functions.
+ */
+static std::string normalize( const std::string& s )
+{
+	std::string out;
+	for( size_t i = 0; i < s.size(); ++i )
+	{
+		bool label = ( s[ i ] == 'L' && i > 0 && ( s[ i - 1 ] == '.' || s[ i - 1 ] == ' ' || s[ i - 1 ] == '\t' ) );
+		out += s[ i ];
+		if( label )
+		{
+			while( i + 1 < s.size() && ( isalnum( (unsigned char)s[ i + 1 ] ) || s[ i + 1 ] == '_' ) ) ++i;
+		}
+	}
+	return out;
+}
+
+/**
+ *	Collects the instructions of every kernel, keyed by name; directives,
+ *	comments and labels are skipped, label numbers are kept for the
+ *	branch checks.
+ */
+static std::map<std::string, Listing> parse( const char* path )
+{
+	std::map<std::string, Listing> kernels;
+	std::ifstream in( path );
+	std::string line;
+	Listing* current = 0;
+
+	while( std::getline( in, line ) )
+	{
+		if( !line.empty() && line[ 0 ] != ' ' && line[ 0 ] != '\t' && line[ line.size() - 1 ] == ':' )
+		{
+			std::string name = line.substr( 0, line.size() - 1 );
+			if( name[ 0 ] == '_' ) name = name.substr( 1 );		// Mach-O prefix
+
+			bool kernel = name.find( "_fixed" ) != std::string::npos || name.find( "_raw" ) != std::string::npos;
+			if( kernel )
+			{
+				current = &kernels[ name ];
+			}
+			else if( name[ 0 ] != '.' && name[ 0 ] != 'L' )
+			{
+				current = 0;
+			}
+			continue;
+		}
+
+		std::string s = trim( line );
+		if( s.compare( 0, 12, ".cfi_endproc" ) == 0 || s.compare( 0, 5, ".size" ) == 0 )
+		{
+			current = 0;
+			continue;
+		}
+
+		if( !current || s.empty() || s[ 0 ] == '.' || s[ 0 ] == '#' || s[ 0 ] == ';' || s[ 0 ] == '@' )
+		{
+			continue;
+		}
+
+		current->push_back( s );
+	}
+
+	return kernels;
+}
+
+static std::string mnemonic( const std::string& s )
+{
+	return s.substr( 0, s.find_first_of( " \t" ) );
+}
+
+static std::string operand( const std::string& s )
+{
+	size_t at = s.find_last_of( " \t," );
+	return at == std::string::npos ? std::string() : s.substr( at + 1 );
+}
+
+/**
+ *	x86 jumps and calls, ARM and AArch64 branches; returns aren't
+ *	counted, every function has one.
+ */
+static bool isBranch( const std::string& s )
+{
+	static const char* arm[] = { "b", "bl", "blx", "br", "blr", "bx", "cbz", "cbnz", "tbz", "tbnz",
+								 "beq", "bne", "bcs", "bhs", "bcc", "blo", "bmi", "bpl", "bvs", "bvc",
+								 "bhi", "bls", "bge", "blt", "bgt", "ble" };
+
+	std::string m = mnemonic( s );
+	if( m[ 0 ] == 'j' || m.compare( 0, 4, "call" ) == 0 || m.compare( 0, 2, "b." ) == 0 )
+	{
+		return true;
+	}
+	for( size_t i = 0; i < sizeof( arm ) / sizeof( arm[ 0 ] ); ++i )
+	{
+		if( m == arm[ i ] ) return true;
+	}
+	return false;
+}
+
+/**
+ *	A branch leaving the function: a call, a tail call or an indirect
+ *	jump, anything not landing on a local label.
+ */
+static bool isCall( const std::string& s )
+{
+	if( !isBranch( s ) )
+	{
+		return false;
+	}
+
+	std::string target = operand( s );
+#if defined( __APPLE__ )
+	return target.compare( 0, 1, "L" ) != 0;
+#else
+	return target.compare( 0, 2, ".L" ) != 0;
+#endif
+}
+
+static int32_t count( const Listing& l, bool ( *what )( const std::string& ) )
+{
+	int32_t n = 0;
+	for( size_t i = 0; i < l.size(); ++i )
+	{
+		n += what( l[ i ] );
+	}
+	return n;
+}
+
+static bool sameInstructions( Listing a, Listing b )
+{
+	for( size_t i = 0; i < a.size(); ++i ) a[ i ] = normalize( a[ i ] );
+	for( size_t i = 0; i < b.size(); ++i ) b[ i ] = normalize( b[ i ] );
+	std::sort( a.begin(), a.end() );
+	std::sort( b.begin(), b.end() );
+	return a == b;
+}
+
+static void print( const char* name, const Listing& l )
+{
+	printf( "    %s:\n", name );
+	for( size_t i = 0; i < l.size(); ++i )
+	{
+		printf( "        %s\n", l[ i ].c_str() );
+	}
+}
+
+
+int main( int argc, char** argv )
+{
+	if( argc < 2 )
+	{
+		fprintf( stderr, "usage: %s kernels.s\n", argv[ 0 ] );
+		return 2;
+	}
+
+	std::map<std::string, Listing> kernels = parse( argv[ 1 ] );
+	const char* formats[] = { "16", "8" };
+	int32_t compared = 0, failed = 0;
+
+	printf( "kernel\t\tfixed\traw\n" );
+
+	for( std::map<std::string, Listing>::const_iterator k = kernels.begin(); k != kernels.end(); ++k )
+	{
+		for( int32_t f = 0; f < 2; ++f )
+		{
+			std::string suffix = std::string( "_fixed" ) + formats[ f ];
+			size_t at = k->first.size() - suffix.size();
+			if( k->first.size() <= suffix.size() || k->first.compare( at, suffix.size(), suffix ) != 0 )
+			{
+				continue;
+			}
+
+			std::string raw = k->first.substr( 0, at ) + "_raw" + formats[ f ];
+			std::map<std::string, Listing>::const_iterator r = kernels.find( raw );
+			if( r == kernels.end() || k->second.empty() || r->second.empty() )
+			{
+				printf( "FAILED: %s has no raw counterpart, or no code\n", k->first.c_str() );
+				++failed;
+				continue;
+			}
+
+			const Listing& fixed = k->second;
+			const Listing& base = r->second;
+			const char* why = 0;
+			if( fixed.size() > base.size() )							why = "more instructions";
+			else if( count( fixed, isCall ) )							why = "calls out";
+			else if( count( fixed, isBranch ) > count( base, isBranch ) )	why = "more branches";
+			bool same = sameInstructions( fixed, base );
+
+			printf( "%-15s\t%d\t%d%s%s\n", k->first.c_str(), int32_t( fixed.size() ), int32_t( base.size() ),
+					why ? "\tFAILED: " : ( same ? "" : "\tdiffers" ), why ? why : "" );
+
+			if( !same )
+			{
+				print( k->first.c_str(), fixed );
+				print( raw.c_str(), base );
+			}
+
+			++compared;
+			failed += why != 0;
+		}
+	}
+
+	if( !compared )
+	{
+		printf( "FAILED: no kernels found in %s\n", argv[ 1 ] );
+		return 1;
+	}
+
+	printf( "%d kernels compared, %d failed\n", compared, failed );
+	return failed ? 1 : 0;
+}
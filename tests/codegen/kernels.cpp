@@ -0,0 +1,103 @@
+/**
+ *	Representative kernels, each written three times: with fixed16_t,
+ *	with fixed8_t, and with raw int32_t macros doing what their policies
+ *	do. Compiled to assembly only, codegen_check compares the results.
+ *
+ *	Every kernel is extern "C" and named <kernel>_<variant>, with the
+ *	variants fixed16 / raw16 and fixed8 / raw8.
+ */
+
+#include "fixedpoint.h"
+
+using namespace fastmath;
+
+
+// raw equivalents of HighPrecision<16> and LowPrecision<8>
+
+#define RAW16_MUL( a, b )		( (int32_t)( ( (int64_t)( a ) * (int64_t)( b ) + 0x8000 ) >> 16 ) )
+#define RAW16_DIV( a, b )		raw16Div( a, b )
+#define RAW16_FROM_INT( i )		( (int32_t)( i ) << 16 )
+#define RAW16_TO_INT( r )		( (int32_t)( r ) >> 16 )
+#define RAW16_FRACTION( r )		( (uint32_t)( r ) & 0xffffu )
+
+#define RAW8_MUL( a, b )		( ( (int32_t)( a ) * (int32_t)( b ) ) >> 8 )
+#define RAW8_DIV( a, b )		( ( (int32_t)( a ) << 8 ) / (int32_t)( b ) )
+#define RAW8_FROM_INT( i )		( (int32_t)( i ) << 8 )
+#define RAW8_TO_INT( r )		( (int32_t)( r ) >> 8 )
+
+static inline int32_t raw16Div( int32_t l, int32_t r )
+{
+	int64_t t = int64_t( l ) << 16;
+	int32_t q = int32_t( t / r );
+	int32_t rem = int32_t( t % r );
+	return q + 1 + ( ( ( rem << 1 ) - r ) >> 31 );
+}
+
+
+/**
+ *	Kernels shared by both formats, Number is the FixedPoint type.
+ */
+#define FIXED_KERNELS( Number, suffix )																	\
+	extern "C" Number add_##suffix( Number a, Number b )				{ return a + b; }					\
+	extern "C" Number sub_##suffix( Number a, Number b )				{ return a - b; }					\
+	extern "C" Number neg_##suffix( Number a )							{ return -a; }						\
+	extern "C" Number mul_##suffix( Number a, Number b )				{ return a * b; }					\
+	extern "C" Number div_##suffix( Number a, Number b )				{ return a / b; }					\
+	extern "C" Number lerp_##suffix( Number a, Number b, Number t )		{ return a + ( b - a ) * t; }		\
+	extern "C" Number madd_##suffix( Number a, Number b, Number c )		{ return a * b + c; }				\
+	extern "C" Number scale_##suffix( Number a, int32_t s )				{ return a * s; }					\
+	extern "C" Number fromint_##suffix( int32_t i )						{ return Number( i ); }				\
+	extern "C" int32_t toint_##suffix( Number a )						{ return a.getInteger(); }			\
+	extern "C" Number min_##suffix( Number a, Number b )				{ return a < b ? a : b; }			\
+	extern "C" int32_t less_##suffix( Number a, Number b )				{ return a < b; }					\
+	extern "C" Number dot3_##suffix( const Number* a, const Number* b )										\
+	{																										\
+		return a[ 0 ] * b[ 0 ] + a[ 1 ] * b[ 1 ] + a[ 2 ] * b[ 2 ];											\
+	}																										\
+	extern "C" Number sum_##suffix( const Number* a, int32_t n )											\
+	{																										\
+		Number s;																							\
+		for( int32_t i = 0; i < n; ++i ) s += a[ i ];														\
+		return s;																							\
+	}																										\
+	extern "C" void axpy_##suffix( Number* y, const Number* x, Number a, int32_t n )						\
+	{																										\
+		for( int32_t i = 0; i < n; ++i ) y[ i ] += a * x[ i ];												\
+	}
+
+#define RAW_KERNELS( bits, suffix )																		\
+	extern "C" int32_t add_##suffix( int32_t a, int32_t b )				{ return a + b; }					\
+	extern "C" int32_t sub_##suffix( int32_t a, int32_t b )				{ return a - b; }					\
+	extern "C" int32_t neg_##suffix( int32_t a )						{ return -a; }						\
+	extern "C" int32_t mul_##suffix( int32_t a, int32_t b )				{ return RAW##bits##_MUL( a, b ); }	\
+	extern "C" int32_t div_##suffix( int32_t a, int32_t b )				{ return RAW##bits##_DIV( a, b ); }	\
+	extern "C" int32_t lerp_##suffix( int32_t a, int32_t b, int32_t t )	{ return a + RAW##bits##_MUL( b - a, t ); }	\
+	extern "C" int32_t madd_##suffix( int32_t a, int32_t b, int32_t c )	{ return RAW##bits##_MUL( a, b ) + c; }	\
+	extern "C" int32_t scale_##suffix( int32_t a, int32_t s )			{ return a * s; }					\
+	extern "C" int32_t fromint_##suffix( int32_t i )					{ return RAW##bits##_FROM_INT( i ); }	\
+	extern "C" int32_t toint_##suffix( int32_t a )						{ return RAW##bits##_TO_INT( a ); }	\
+	extern "C" int32_t min_##suffix( int32_t a, int32_t b )				{ return a < b ? a : b; }			\
+	extern "C" int32_t less_##suffix( int32_t a, int32_t b )			{ return a < b; }					\
+	extern "C" int32_t dot3_##suffix( const int32_t* a, const int32_t* b )									\
+	{																										\
+		return RAW##bits##_MUL( a[ 0 ], b[ 0 ] ) + RAW##bits##_MUL( a[ 1 ], b[ 1 ] ) + RAW##bits##_MUL( a[ 2 ], b[ 2 ] );	\
+	}																										\
+	extern "C" int32_t sum_##suffix( const int32_t* a, int32_t n )											\
+	{																										\
+		int32_t s = 0;																						\
+		for( int32_t i = 0; i < n; ++i ) s += a[ i ];														\
+		return s;																							\
+	}																										\
+	extern "C" void axpy_##suffix( int32_t* y, const int32_t* x, int32_t a, int32_t n )					\
+	{																										\
+		for( int32_t i = 0; i < n; ++i ) y[ i ] += RAW##bits##_MUL( a, x[ i ] );							\
+	}
+
+FIXED_KERNELS( fixed16_t, fixed16 )
+FIXED_KERNELS( fixed8_t, fixed8 )
+RAW_KERNELS( 16, raw16 )
+RAW_KERNELS( 8, raw8 )
+
+// fixed16_t only
+extern "C" uint32_t fraction_fixed16( fixed16_t a )		{ return a.getFraction(); }
+extern "C" uint32_t fraction_raw16( int32_t a )			{ return RAW16_FRACTION( a ); }
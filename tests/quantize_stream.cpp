@@ -0,0 +1,209 @@
+/**
+ *	Streams a dataset through fixedpoint_quantize.h in fixed-size chunks,
+ *	per block and per channel, and checks the round trip: every value
+ *	comes back within half a step of its format, the precision is the
+ *	largest one the range allows, and the results don't depend on the
+ *	number of threads. Also covers infinities, empty input and rounding
+ *	at the halfway point.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+#include "fixedpoint_quantize.h"
+
+using namespace fastmath;
+
+
+// local helpers
+
+static bool check( bool ok, const char* what )
+{
+	if( !ok )
+	{
+		printf( "FAILED: %s\n", what );
+	}
+	return ok;
+}
+
+/**
+ *	Values spanning a range that changes every 300 values, so that
+ *	blocks and chunks see very different precisions.
+ */
+static void generate( float* out, size_t at, size_t count )
+{
+	for( size_t i = 0; i < count; ++i )
+	{
+		uint32_t seed = uint32_t( at + i ) * 2654435761u;
+		seed ^= seed >> 15;
+		seed *= 2246822519u;
+		seed ^= seed >> 13;
+		float unit = ( int32_t( seed >> 8 ) - 0x800000 ) / 8388608.0f;
+		out[ i ] = ldexpf( unit, int32_t( ( at + i ) / 300 % 32 ) - 16 );
+	}
+}
+
+/**
+ *	Half a step of the format, plus the rounding of the int32_t to float
+ *	on the way back.
+ */
+static bool withinStep( float x, float y, int8_t bits )
+{
+	return fabs( double( x ) - y ) <= ldexp( 0.5, -bits ) + fabs( x ) * ldexp( 1.0, -23 );
+}
+
+/**
+ *	The largest precision that doesn't overflow.
+ */
+static bool tightPrecision( float maxAbs, int8_t bits )
+{
+	bool fits = ldexp( maxAbs, bits ) < 2147483648.0;
+	bool largest = bits == QUANTIZE_MAX_BITS || ldexp( maxAbs, bits + 1 ) >= 2147483648.0;
+	return fits && ( maxAbs == 0 || largest );
+}
+
+static bool streamBlocks( size_t total, size_t chunk, size_t blockSize )
+{
+	std::vector<float> in( chunk ), out( chunk );
+	std::vector<int32_t> raw( chunk ), raw1( chunk );
+	std::vector<int8_t> bits( chunk / blockSize + 1 ), bits1( chunk / blockSize + 1 );
+	bool ok = true;
+
+	for( size_t at = 0; at < total; at += chunk )
+	{
+		size_t n = at + chunk < total ? chunk : total - at;
+		generate( &in[ 0 ], at, n );
+
+		quantizeBlocks( &in[ 0 ], n, blockSize, &raw[ 0 ], &bits[ 0 ], 3 );
+		quantizeBlocks( &in[ 0 ], n, blockSize, &raw1[ 0 ], &bits1[ 0 ], 1 );
+		dequantizeBlocks( &raw[ 0 ], &bits[ 0 ], n, blockSize, &out[ 0 ], 3 );
+
+		ok &= raw == raw1 && bits == bits1;
+		for( size_t b = 0; b * blockSize < n; ++b )
+		{
+			size_t end = ( b + 1 ) * blockSize < n ? ( b + 1 ) * blockSize : n;
+			ok &= tightPrecision( maxAbs( &in[ b * blockSize ], end - b * blockSize, 1 ), bits[ b ] );
+			for( size_t i = b * blockSize; i < end; ++i )
+			{
+				ok &= withinStep( in[ i ], out[ i ], bits[ b ] );
+			}
+		}
+	}
+
+	return ok;
+}
+
+static bool streamChannels( size_t total, size_t chunk, int32_t channels )
+{
+	std::vector<float> in( chunk * channels ), out( chunk * channels );
+	std::vector<int32_t> raw( chunk * channels );
+	std::vector<int8_t> bits( channels );
+	ChannelRange range( channels ), serial( channels );
+	bool ok = true;
+
+	// range pass, then the quantization pass, over the same chunks
+	for( size_t at = 0; at < total; at += chunk )
+	{
+		size_t n = at + chunk < total ? chunk : total - at;
+		generate( &in[ 0 ], at * channels, n * channels );
+		range.scan( &in[ 0 ], n, 3 );
+		serial.scan( &in[ 0 ], n, 1 );
+	}
+
+	range.getPrecisions( &bits[ 0 ] );
+	for( int32_t c = 0; c < channels; ++c )
+	{
+		ok &= range.getMaxAbs( c ) == serial.getMaxAbs( c );
+		ok &= tightPrecision( range.getMaxAbs( c ), bits[ c ] );
+	}
+
+	for( size_t at = 0; at < total; at += chunk )
+	{
+		size_t n = at + chunk < total ? chunk : total - at;
+		generate( &in[ 0 ], at * channels, n * channels );
+		quantizeChannels( &in[ 0 ], n, channels, &bits[ 0 ], &raw[ 0 ], 3 );
+		dequantizeChannels( &raw[ 0 ], n, channels, &bits[ 0 ], &out[ 0 ], 3 );
+
+		for( size_t i = 0; i < n * channels; ++i )
+		{
+			ok &= withinStep( in[ i ], out[ i ], bits[ i % channels ] );
+		}
+	}
+
+	return ok;
+}
+
+/**
+ *	Infinities saturate, the finite values alone pick the precision.
+ */
+static bool infinities()
+{
+	const float inf = HUGE_VALF;
+	const float in[] = { inf, 2.0f, -inf, -1.5f, inf, inf };
+	int32_t raw[ 6 ];
+	int8_t bits[ 2 ];
+	float out[ 6 ];
+
+	quantizeBlocks( in, 6, 4, raw, bits, 1 );
+	dequantizeBlocks( raw, bits, 6, 4, out, 1 );
+
+	bool ok = bits[ 0 ] == 29 && bits[ 1 ] == QUANTIZE_MAX_BITS;
+	ok &= out[ 1 ] == 2.0f && out[ 3 ] == -1.5f;
+	ok &= raw[ 0 ] == 2147483647 && raw[ 2 ] == -2147483647 && raw[ 4 ] == 2147483647;
+
+	ChannelRange range( 2 );
+	range.scan( in, 3, 2 );
+	ok &= range.getPrecision( 0 ) == QUANTIZE_MAX_BITS && range.getPrecision( 1 ) == 29;
+	return ok;
+}
+
+/**
+ *	Nothing is read nor written.
+ */
+static bool empty()
+{
+	int32_t raw[ 1 ] = { 42 };
+	int8_t bits[ 1 ] = { 42 };
+	float out[ 1 ] = { 42.0f };
+
+	quantizeBlocks( 0, 0, 256, raw, bits, 3 );
+	dequantizeBlocks( raw, bits, 0, 256, out, 3 );
+	quantizeChannels( 0, 0, 1, bits, raw, 3 );
+	dequantizeChannels( raw, 0, 1, bits, out, 3 );
+
+	ChannelRange range( 3 );
+	range.scan( 0, 0, 3 );
+
+	return raw[ 0 ] == 42 && bits[ 0 ] == 42 && out[ 0 ] == 42.0f && range.getMaxAbs( 2 ) == 0.0f &&
+		   range.getPrecision( 2 ) == QUANTIZE_MAX_BITS;
+}
+
+static bool rounding()
+{
+	return quantizeValue( 0.49999997f, 1.0f ) == 0 && quantizeValue( -0.49999997f, 1.0f ) == 0 &&
+		   quantizeValue( 0.5f, 1.0f ) == 1 && quantizeValue( -0.5f, 1.0f ) == -1 &&
+		   quantizeValue( 1.4999999f, 1.0f ) == 1 && quantizeValue( 2.5f, 1.0f ) == 3 &&
+		   quantizeValue( 8388607.5f, 1.0f ) == 8388608 && quantizeValue( 0.25f, 2.0f ) == 1;
+}
+
+
+int main()
+{
+	bool ok = true;
+
+	// chunks a multiple of the block size, and a last partial one
+	ok &= check( streamBlocks( 100000, 4096, 256 ), "per-block round trip" );
+	ok &= check( streamBlocks( 5050, 1000, 100 ), "per-block round trip, partial blocks" );
+	ok &= check( streamChannels( 30000, 1000, 4 ), "per-channel round trip" );
+	ok &= check( streamChannels( 7, 3, 3 ), "per-channel round trip, small chunks" );
+	ok &= check( infinities(), "infinities" );
+	ok &= check( empty(), "empty input" );
+	ok &= check( rounding(), "rounding" );
+
+	if( ok )
+	{
+		printf( "ok\n" );
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,231 @@
+/**
+ *	Replay test for fixedpoint_sim.h: the same scene, stepped with every
+ *	integrator and 1, 2, 3 and 7 threads, must give bit-exact state hashes
+ *	at every step, and the broadphase must find exactly the pairs a brute
+ *	force test finds.
+ *
+ *	The final hashes must also match the golden ones below, recorded once,
+ *	so that a different compiler, build or machine can't drift either.
+ */
+
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+#include "fixedpoint_sim.h"
+
+using namespace fastmath;
+
+
+/**
+ *	Spring towards the origin with some drag, so that the acceleration
+ *	depends on the whole state.
+ */
+struct Spring
+{
+	inline void operator()( const fixed16_t& x, const fixed16_t& y, const fixed16_t& u, const fixed16_t& v, fixed16_t& ax, fixed16_t& ay ) const
+	{
+		ax = -x / 4 - u / 16;
+		ay = -y / 4 - v / 16 - fixed16_t( 1 );
+	}
+};
+
+enum Integrator { EULER, VERLET, RK4 };
+static const char* integratorNames[] = { "Euler", "Verlet", "RK4" };
+
+// state and pairs hashes after the last step
+static const uint64_t golden[][ 2 ] =
+{
+	{ 0x661d199411b3a5acull, 0x4be6ac4554dfa673ull },
+	{ 0xe7e6a29bd87e8f5bull, 0xa76f170ba1e52350ull },
+	{ 0xe49ceb19e31cc342ull, 0xa76f170ba1e52350ull }
+};
+
+
+// local helpers
+
+static bool check( bool ok, const char* what, int32_t threads )
+{
+	if( !ok )
+	{
+		printf( "FAILED: %s, %d threads\n", what, threads );
+	}
+	return ok;
+}
+
+static uint64_t pairsHash( const std::vector<BodyPair>& pairs )
+{
+	uint64_t h = 14695981039346656037ull;
+	for( size_t i = 0; i < pairs.size(); ++i )
+	{
+		h = ( h ^ pairs[ i ].a ) * 1099511628211ull;
+		h = ( h ^ pairs[ i ].b ) * 1099511628211ull;
+	}
+	return h;
+}
+
+static bool lessPair( const BodyPair& l, const BodyPair& r )
+{
+	return l.a != r.a ? l.a < r.a : l.b < r.b;
+}
+
+/**
+ *	Reference overlap test, in 128 bits where available.
+ */
+static bool overlaps( const BodySet<fixed16_t>& b, uint32_t i, uint32_t j )
+{
+	int64_t dx = int64_t( b.px[ i ].getRaw() ) - b.px[ j ].getRaw();
+	int64_t dy = int64_t( b.py[ i ].getRaw() ) - b.py[ j ].getRaw();
+	int64_t r = int64_t( b.radius[ i ].getRaw() ) + b.radius[ j ].getRaw();
+#if defined( __SIZEOF_INT128__ )
+	return __int128( dx ) * dx + __int128( dy ) * dy < __int128( r ) * r;
+#else
+	return (long double)dx * dx + (long double)dy * dy < (long double)r * r;
+#endif
+}
+
+static std::vector<BodyPair> bruteForce( const BodySet<fixed16_t>& b )
+{
+	std::vector<BodyPair> pairs;
+	for( uint32_t i = 0; i < b.size(); ++i )
+	{
+		for( uint32_t j = i + 1; j < b.size(); ++j )
+		{
+			if( overlaps( b, i, j ) )
+			{
+				BodyPair p = { i, j };
+				pairs.push_back( p );
+			}
+		}
+	}
+	return pairs;
+}
+
+static BodySet<fixed16_t> makeScene( int32_t count )
+{
+	BodySet<fixed16_t> b;
+	uint32_t seed = 12345;
+	for( int32_t i = 0; i < count; ++i )
+	{
+		int32_t v[ 5 ];
+		for( int32_t k = 0; k < 5; ++k )
+		{
+			seed = seed * 1664525u + 1013904223u;
+			v[ k ] = int32_t( seed >> 8 );
+		}
+
+		// positions in [-64, 64), velocities in [-8, 8), radii in [0.05, 0.5)
+		b.add( fixed16_t::fromRaw( ( v[ 0 ] & 0x7fffff ) - 0x400000 ), fixed16_t::fromRaw( ( v[ 1 ] & 0x7fffff ) - 0x400000 ),
+			   fixed16_t::fromRaw( ( v[ 2 ] & 0xfffff ) - 0x80000 ), fixed16_t::fromRaw( ( v[ 3 ] & 0xfffff ) - 0x80000 ),
+			   fixed16_t::fromRaw( 0xccc + v[ 4 ] % 0x7333 ) );
+	}
+	return b;
+}
+
+/**
+ *	Runs the scene, returns one state hash and one pairs hash per step.
+ */
+static void run( Integrator integrator, int32_t threads, int32_t bodies, int32_t steps,
+				 std::vector<uint64_t>& states, std::vector<uint64_t>& pairs, bool& exact )
+{
+	BodySet<fixed16_t> b = makeScene( bodies );
+	UniformGrid<fixed16_t> grid( fixed16_t( 1 ) );
+	const fixed16_t dt = fixed16_t( 1.0f / 60 );
+	std::vector<BodyPair> found;
+	Spring spring;
+
+	states.clear();
+	pairs.clear();
+	exact = true;
+
+	for( int32_t s = 0; s < steps; ++s )
+	{
+		switch( integrator )
+		{
+			case EULER:		integrateEuler( b, spring, dt, threads ); break;
+			case VERLET:	integrateVerlet( b, spring, dt, threads ); break;
+			case RK4:		integrateRK4( b, spring, dt, threads ); break;
+		}
+
+		grid.build( b, threads );
+		grid.findPairs( b, found, threads );
+
+		states.push_back( stateHash( b ) );
+		pairs.push_back( pairsHash( found ) );
+
+		// the brute force is quadratic, check a few steps only
+		if( s % 16 == 0 || s == steps - 1 )
+		{
+			std::vector<BodyPair> expected = bruteForce( b );
+			std::sort( found.begin(), found.end(), lessPair );
+			bool same = found.size() == expected.size();
+			for( size_t i = 0; same && i < found.size(); ++i )
+			{
+				same = found[ i ].a == expected[ i ].a && found[ i ].b == expected[ i ].b;
+			}
+			exact &= same;
+		}
+	}
+}
+
+/**
+ *	Bodies in neighbouring cells of the largest size fixed16_t allows,
+ *	where dx^2 alone doesn't fit an int64_t.
+ */
+static bool farApart()
+{
+	BodySet<fixed16_t> b;
+	const fixed16_t r = fixed16_t( 16383 );
+	b.add( fixed16_t( -32767 ), fixed16_t( 0 ), fixed16_t(), fixed16_t(), r );
+	b.add( fixed16_t( 32752 ), fixed16_t( 0 ), fixed16_t(), fixed16_t(), r );
+	b.add( fixed16_t( -32767 ), fixed16_t( 1 ), fixed16_t(), fixed16_t(), r );
+
+	UniformGrid<fixed16_t> grid( fixed16_t( 32767 ) );
+	std::vector<BodyPair> found;
+	grid.build( b, 1 );
+	grid.findPairs( b, found, 1 );
+
+	std::vector<BodyPair> expected = bruteForce( b );
+	std::sort( found.begin(), found.end(), lessPair );
+	bool same = found.size() == expected.size() && expected.size() == 1;
+	for( size_t i = 0; same && i < found.size(); ++i )
+	{
+		same = found[ i ].a == expected[ i ].a && found[ i ].b == expected[ i ].b;
+	}
+	return same;
+}
+
+
+int main()
+{
+	const int32_t bodies = 2000;
+	const int32_t steps = 50;
+	const int32_t threadCounts[] = { 1, 2, 3, 7 };
+	bool ok = true;
+
+	for( int32_t g = EULER; g <= RK4; ++g )
+	{
+		std::vector<uint64_t> refStates, refPairs, states, pairs;
+		bool exact;
+
+		run( Integrator( g ), 1, bodies, steps, refStates, refPairs, exact );
+		ok &= check( exact, integratorNames[ g ], 1 );
+
+		for( size_t t = 0; t < sizeof( threadCounts ) / sizeof( threadCounts[ 0 ] ); ++t )
+		{
+			// threads = 1 again is the plain replay
+			run( Integrator( g ), threadCounts[ t ], bodies, steps, states, pairs, exact );
+			ok &= check( states == refStates, "state hashes differ", threadCounts[ t ] );
+			ok &= check( pairs == refPairs, "pairs differ", threadCounts[ t ] );
+			ok &= check( exact, "pairs don't match the brute force", threadCounts[ t ] );
+		}
+
+		printf( "%s\t%016llx\t%016llx\n", integratorNames[ g ], (unsigned long long)refStates.back(), (unsigned long long)refPairs.back() );
+		ok &= check( refStates.back() == golden[ g ][ 0 ], "state hash differs from the golden one", 1 );
+		ok &= check( refPairs.back() == golden[ g ][ 1 ], "pairs hash differs from the golden one", 1 );
+	}
+
+	ok &= check( farApart(), "far apart bodies", 1 );
+
+	return ok ? 0 : 1;
+}
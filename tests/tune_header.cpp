@@ -0,0 +1,17 @@
+/**
+ *	Compiled against the header tune_lerp emits: it must stand on its
+ *	own, twice included, and define a usable lerp_fixed_t.
+ */
+
+#include "lerp_fixed_t.h"
+#include "lerp_fixed_t.h"
+
+using namespace fastmath;
+
+
+int main()
+{
+	lerp_fixed_t a( 1.0f ), b( 3.0f ), t( 0.5f );
+	lerp_fixed_t r = a + ( b - a ) * t;
+	return r.getInteger() == 2 ? 0 : 1;
+}
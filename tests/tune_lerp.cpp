@@ -0,0 +1,122 @@
+/**
+ *	Runs the README example of fixedpoint_tune.h, a Lerp kernel over
+ *	every bits x policy combination, and checks the frontier, the
+ *	recommendation and the emitted header; the header is written to the
+ *	path given, if any, tune_header.cpp then compiles against it.
+ */
+
+#include <stdio.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "fixedpoint_tune.h"
+
+using namespace fastmath;
+
+
+struct Lerp
+{
+	template<class Number>
+	Number operator()( const Number* a ) const { return a[0] + ( a[1] - a[0] ) * a[2]; }
+};
+
+
+// local helpers
+
+static bool check( bool ok, const char* what )
+{
+	if( !ok )
+	{
+		printf( "FAILED: %s\n", what );
+	}
+	return ok;
+}
+
+static bool contains( const std::string& s, const std::string& what )
+{
+	return s.find( what ) != std::string::npos;
+}
+
+/**
+ *	No starred row may be dominated by another one, as report() prints
+ *	them.
+ */
+static bool consistentFrontier( const std::vector<TuneResult>& results )
+{
+	bool ok = true;
+	for( size_t i = 0; i < results.size(); ++i )
+	{
+		const TuneResult& r = results[ i ];
+		ok &= r.groupSamplesPerSecond >= r.samplesPerSecond;
+
+		for( size_t j = 0; r.pareto && j < results.size(); ++j )
+		{
+			const TuneResult& o = results[ j ];
+			bool sameError = o.maxError == r.maxError && o.rmsError == r.rmsError;
+			ok &= sameError ? !o.pareto || j == i :
+				  !( o.groupSamplesPerSecond >= r.groupSamplesPerSecond && o.maxError <= r.maxError &&
+					 ( o.groupSamplesPerSecond > r.groupSamplesPerSecond || o.maxError < r.maxError ) );
+		}
+	}
+	return ok;
+}
+
+
+int main( int argc, char** argv )
+{
+	const long double tolerance = 0.001;
+	bool ok = true;
+
+	// a, b in [-4, 4), t in [0, 1)
+	std::vector<long double> samples;
+	uint32_t seed = 1;
+	for( int32_t i = 0; i < 3000; ++i )
+	{
+		for( int32_t k = 0; k < 3; ++k )
+		{
+			seed = seed * 1664525u + 1013904223u;
+			long double u = ( seed >> 8 ) / 16777216.0L;
+			samples.push_back( k < 2 ? u * 8 - 4 : u );
+		}
+	}
+
+	PolicyTuner<Lerp> tuner( Lerp(), 3, samples, 0.002 );
+	tuner.run( BitsList<8, 12, 16>(), PolicyList<HighPrecision, MidPrecision, LowPrecision>() );
+	tuner.report( std::cout );
+
+	ok &= check( tuner.getResults().size() == 27, "one result per configuration" );
+	ok &= check( consistentFrontier( tuner.getResults() ), "frontier" );
+
+	const TuneResult* best = tuner.recommend( tolerance );
+	ok &= check( best && best->pareto && best->maxError <= tolerance, "recommendation" );
+
+	std::ostringstream header;
+	ok &= check( tuner.emitHeader( header, "lerp_fixed_t", tolerance ), "emitHeader" );
+	if( best )
+	{
+		std::ostringstream typedefLine;
+		typedefLine << "typedef FixedPoint< " << best->bits << ", " << best->mulPolicy << ", " << best->divPolicy << " > lerp_fixed_t;";
+
+		const std::string h = header.str();
+		ok &= check( contains( h, typedefLine.str() ), "typedef of the recommendation" );
+		ok &= check( contains( h, "#ifndef LERP_FIXED_T_H\n#define LERP_FIXED_T_H\n" ), "include guard" );
+		ok &= check( contains( h, "#endif\t// LERP_FIXED_T_H\n" ), "include guard end" );
+		ok &= check( contains( h, "#include \"fixedpoint.h\"" ), "include" );
+	}
+
+	std::ostringstream none;
+	ok &= check( !tuner.emitHeader( none, "lerp_fixed_t", -1 ) && none.str().empty(), "no header without a recommendation" );
+
+	if( argc > 1 )
+	{
+		std::ofstream out( argv[ 1 ] );
+		out << header.str();
+		ok &= check( bool( out ), "writing the header" );
+	}
+
+	std::cout << header.str();
+	return ok ? 0 : 1;
+}